@@ -0,0 +1,93 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+
+namespace ats
+{
+	// Fixed number of worker threads running submitted tasks in the order of submission. The result of
+	// a task (or the exception it throws) is obtained through the future returned by submit
+	class thread_pool
+	{
+	public:
+		// Zero threads means one per hardware thread
+		explicit thread_pool(size_t threads = 0)
+		{
+			if (threads == 0)
+				threads = std::max(1U, std::thread::hardware_concurrency());
+
+			workers_.reserve(threads);
+			for (size_t i = 0; i < threads; ++i)
+				workers_.emplace_back(&thread_pool::work, this);
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		// Waits until all submitted tasks have run
+		~thread_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			condition_.notify_all();
+			for (auto& worker : workers_)
+				worker.join();
+		}
+
+		template<typename FuncT>
+		std::future<typename std::result_of<FuncT()>::type> submit(FuncT&& func)
+		{
+			typedef typename std::result_of<FuncT()>::type result_type;
+
+			// std::function requires a copyable target, hence the shared task
+			auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<FuncT>(func));
+			std::future<result_type> result = task->get_future();
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks_.push([task]() { (*task)(); });
+			}
+			condition_.notify_one();
+			return result;
+		}
+
+		size_t size() const { return workers_.size(); }
+
+	private:
+		void work()
+		{
+			for (;;)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+					if (tasks_.empty())
+						return;
+					task = std::move(tasks_.front());
+					tasks_.pop();
+				}
+				task();
+			}
+		}
+
+	private:
+		std::vector<std::thread> workers_;
+		std::queue<std::function<void()>> tasks_;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		bool stop_ = false;
+	};
+}
+
+#endif
\ No newline at end of file
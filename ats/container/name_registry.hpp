@@ -0,0 +1,173 @@
+#ifndef NAME_REGISTRY_HPP
+#define NAME_REGISTRY_HPP
+
+#include <cstdint>
+#include <string>
+#include <array>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace ats
+{
+	// Interns names (symbols, exchanges) into dense ids, so that messages, orders and engines carry
+	// integers and names are only looked up for I/O and logging. Ids are assigned in the order names are
+	// first seen and are never reused, so that references returned by name() stay valid. Thread-safe,
+	// since readers of parallel runs intern their names concurrently.
+	//
+	// Names are appended to chunks that never move, and ids to an open-addressing table whose slots are
+	// only ever filled, and which is replaced by a larger copy when it grows. name(), find() and intern()
+	// of a known name thus do not lock; only new names are added under the mutex, one at a time
+	class name_registry
+	{
+	public:
+		typedef uint32_t id_type;
+
+		// Id of no name (e.g., of a default-constructed message)
+		static constexpr id_type npos = std::numeric_limits<id_type>::max();
+
+		name_registry() { table_.store(new_table(16), std::memory_order_relaxed); }
+
+		~name_registry()
+		{
+			for (auto& chunk : chunks_)
+				delete[] chunk.load(std::memory_order_relaxed);
+		}
+
+		name_registry(const name_registry&) = delete;
+		name_registry& operator=(const name_registry&) = delete;
+
+		// Returns the id of a name, assigning the next id to a new name
+		id_type intern(const std::string& name)
+		{
+			size_t hash = std::hash<std::string>()(name);
+			id_type id = lookup(*table_.load(std::memory_order_acquire), name, hash);
+			if (id != npos)
+				return id;
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			table* current = table_.load(std::memory_order_relaxed);
+			id = lookup(*current, name, hash);
+			if (id != npos)
+				return id;
+
+			id = size_.load(std::memory_order_relaxed);
+			if (id >= chunk_size * max_chunks)
+				throw std::length_error("name_registry: Too many names");
+			std::string* chunk = chunks_[id / chunk_size].load(std::memory_order_relaxed);
+			if (chunk == nullptr)
+			{
+				chunk = new std::string[chunk_size];
+				chunks_[id / chunk_size].store(chunk, std::memory_order_relaxed);
+			}
+			chunk[id % chunk_size] = name;
+			size_.store(id + 1, std::memory_order_release);
+
+			// The table is kept at most half full; a grown table is published once filled
+			if (2 * (size_t)(id + 1) > current->slots.size())
+			{
+				table* grown = new_table(2 * current->slots.size());
+				for (id_type i = 0; i <= id; ++i)
+					insert(*grown, i, std::hash<std::string>()(get(i)));
+				table_.store(grown, std::memory_order_release);
+			}
+			else
+				insert(*current, id, hash);
+			return id;
+		}
+
+		// Returns the id of a name, npos if the name has not been interned
+		id_type find(const std::string& name) const
+		{
+			return lookup(*table_.load(std::memory_order_acquire), name, std::hash<std::string>()(name));
+		}
+
+		// Returns the name of an id (an empty name for npos)
+		const std::string& name(id_type id) const
+		{
+			static const std::string empty;
+			if (id == npos)
+				return empty;
+
+			if (id >= size_.load(std::memory_order_acquire))
+				throw std::out_of_range("name_registry: Unknown id " + std::to_string(id));
+			return get(id);
+		}
+
+		size_t size() const { return size_.load(std::memory_order_acquire); }
+
+	private:
+		static constexpr size_t chunk_size = 1024;
+		static constexpr size_t max_chunks = 4096;
+
+		// Ids by hash of their name; npos marks an empty slot
+		struct table
+		{
+			std::vector<std::atomic<id_type>> slots;
+
+			explicit table(size_t size) : slots(size)
+			{
+				for (auto& slot : slots)
+					slot.store(npos, std::memory_order_relaxed);
+			}
+		};
+
+		table* new_table(size_t size)
+		{
+			tables_.push_back(std::make_unique<table>(size));
+			return tables_.back().get();
+		}
+
+		// Name of an id known to be published
+		const std::string& get(id_type id) const
+		{
+			return chunks_[id / chunk_size].load(std::memory_order_acquire)[id % chunk_size];
+		}
+
+		id_type lookup(const table& t, const std::string& name, size_t hash) const
+		{
+			size_t mask = t.slots.size() - 1;
+			for (size_t i = hash & mask; ; i = (i + 1) & mask)
+			{
+				id_type id = t.slots[i].load(std::memory_order_acquire);
+				if (id == npos || get(id) == name)
+					return id;
+			}
+		}
+
+		static void insert(table& t, id_type id, size_t hash)
+		{
+			size_t mask = t.slots.size() - 1;
+			size_t i = hash & mask;
+			while (t.slots[i].load(std::memory_order_relaxed) != npos)
+				i = (i + 1) & mask;
+			t.slots[i].store(id, std::memory_order_release);
+		}
+
+	private:
+		std::mutex mutex_;                                 // serializes new names
+		std::array<std::atomic<std::string*>, max_chunks> chunks_{};
+		std::atomic<id_type> size_{ 0 };
+		std::atomic<table*> table_{ nullptr };
+		std::vector<std::unique_ptr<table>> tables_;       // replaced tables are kept for readers still probing them
+	};
+
+	// Registries shared by the process
+	inline ats::name_registry& symbol_registry()
+	{
+		static ats::name_registry registry;
+		return registry;
+	}
+
+	inline ats::name_registry& exchange_registry()
+	{
+		static ats::name_registry registry;
+		return registry;
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,213 @@
+#ifndef ORDER_INDEX_HPP
+#define ORDER_INDEX_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <ats/types.hpp>
+
+namespace ats
+{
+	// Map from order ids to T (e.g., the orders of a portfolio or an engine, or the queue positions of
+	// simulated orders) in a flat open-addressing table. Ids are their own hash: the ids handed out by
+	// portfolio_base::get_next_order_id are sequential, so that live orders fill consecutive slots and
+	// rarely collide. Collisions are resolved by linear probing and erasing shifts the following entries
+	// back instead of leaving tombstones, so that churn of orders neither allocates nor degrades lookups.
+	// As with rehashing, inserting invalidates iterators; erasing moves entries, so that entries must not
+	// be erased while iterating
+	template<typename T>
+	class order_index
+	{
+		struct slot
+		{
+			std::pair<ats::orderid_t, T> entry;
+			bool is_used = false;
+		};
+
+	public:
+		typedef ats::orderid_t key_type;
+		typedef T mapped_type;
+		typedef std::pair<ats::orderid_t, T> value_type;
+
+		template<bool is_const>
+		class basic_iterator
+		{
+			friend class order_index;
+			typedef typename std::conditional<is_const, const slot*, slot*>::type slot_pointer;
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef typename order_index::value_type value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef typename std::conditional<is_const, const value_type*, value_type*>::type pointer;
+			typedef typename std::conditional<is_const, const value_type&, value_type&>::type reference;
+
+			basic_iterator() = default;
+
+			// An iterator converts to a const_iterator
+			template<bool other_const, typename = typename std::enable_if<is_const && !other_const>::type>
+			basic_iterator(const basic_iterator<other_const>& other) : slot_(other.slot_), end_(other.end_) { }
+
+			reference operator*() const { return slot_->entry; }
+			pointer operator->() const { return &slot_->entry; }
+
+			basic_iterator& operator++() { ++slot_; skip(); return *this; }
+			basic_iterator operator++(int) { basic_iterator it = *this; ++*this; return it; }
+
+			template<bool other_const>
+			bool operator==(const basic_iterator<other_const>& other) const { return slot_ == other.slot_; }
+			template<bool other_const>
+			bool operator!=(const basic_iterator<other_const>& other) const { return slot_ != other.slot_; }
+
+		private:
+			template<bool> friend class basic_iterator;
+
+			basic_iterator(slot_pointer s, slot_pointer end) : slot_(s), end_(end) { }
+
+			void skip()
+			{
+				while (slot_ != end_ && !slot_->is_used)
+					++slot_;
+			}
+
+			slot_pointer slot_ = nullptr;
+			slot_pointer end_ = nullptr;
+		};
+
+		typedef basic_iterator<false> iterator;
+		typedef basic_iterator<true> const_iterator;
+
+		explicit order_index(size_t capacity = 64U)
+		{
+			size_t n = min_capacity;
+			while (n < 2 * capacity)
+				n *= 2;
+			slots_.resize(n);
+		}
+
+		iterator begin() { iterator it(slots_.data(), slots_.data() + slots_.size()); it.skip(); return it; }
+		iterator end() { return iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size()); }
+		const_iterator begin() const { const_iterator it(slots_.data(), slots_.data() + slots_.size()); it.skip(); return it; }
+		const_iterator end() const { return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size()); }
+		const_iterator cbegin() const { return begin(); }
+		const_iterator cend() const { return end(); }
+
+		bool empty() const { return size_ == 0; }
+		size_t size() const { return size_; }
+
+		iterator find(ats::orderid_t id)
+		{
+			size_t index = position(id);
+			return slots_[index].is_used ? make_iterator(index) : end();
+		}
+
+		const_iterator find(ats::orderid_t id) const
+		{
+			size_t index = position(id);
+			return slots_[index].is_used ? const_iterator(&slots_[index], slots_.data() + slots_.size()) : end();
+		}
+
+		// As with std::unordered_map, an existing entry is kept
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			size_t index = position(value.first);
+			if (slots_[index].is_used)
+				return std::make_pair(make_iterator(index), false);
+
+			if (2 * (size_ + 1) > slots_.size())
+			{
+				grow();
+				index = position(value.first);
+			}
+			slots_[index].entry = value;
+			slots_[index].is_used = true;
+			++size_;
+			return std::make_pair(make_iterator(index), true);
+		}
+
+		T& operator[](ats::orderid_t id)
+		{
+			return insert(value_type(id, T())).first->second;
+		}
+
+		void erase(const_iterator position)
+		{
+			erase_slot(static_cast<size_t>(position.slot_ - slots_.data()));
+		}
+
+		size_t erase(ats::orderid_t id)
+		{
+			size_t index = position(id);
+			if (!slots_[index].is_used)
+				return 0;
+			erase_slot(index);
+			return 1;
+		}
+
+		void clear()
+		{
+			for (auto& s : slots_)
+			{
+				if (s.is_used)
+					s = slot();
+			}
+			size_ = 0;
+		}
+
+	private:
+		static constexpr size_t min_capacity = 16U;
+
+		size_t mask() const { return slots_.size() - 1; }
+
+		// Slot of an id, or the free slot that ends its probe sequence
+		size_t position(ats::orderid_t id) const
+		{
+			size_t index = static_cast<size_t>(id) & mask();
+			while (slots_[index].is_used && slots_[index].entry.first != id)
+				index = (index + 1) & mask();
+			return index;
+		}
+
+		iterator make_iterator(size_t index) { return iterator(&slots_[index], slots_.data() + slots_.size()); }
+
+		// Backward shift deletion: entries after the slot move into it unless that would put them before
+		// their home slot
+		void erase_slot(size_t index)
+		{
+			size_t next = (index + 1) & mask();
+			while (slots_[next].is_used)
+			{
+				size_t home = static_cast<size_t>(slots_[next].entry.first) & mask();
+				if (((next - home) & mask()) >= ((next - index) & mask()))
+				{
+					slots_[index] = std::move(slots_[next]);
+					index = next;
+				}
+				next = (next + 1) & mask();
+			}
+			slots_[index] = slot();
+			--size_;
+		}
+
+		void grow()
+		{
+			std::vector<slot> slots(2 * slots_.size());
+			slots.swap(slots_);
+			for (auto& s : slots)
+			{
+				if (s.is_used)
+				{
+					size_t index = position(s.entry.first);
+					slots_[index] = std::move(s);
+				}
+			}
+		}
+
+	private:
+		std::vector<slot> slots_;  // a power of two of slots, at most half of them used
+		size_t size_ = 0;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef FIX_MESSAGE_READER_HPP
+#define FIX_MESSAGE_READER_HPP
+
+#include <string>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <ats/data_feed/historical/exchange_message_reader_base.hpp>
+#include <ats/message/level2_message.hpp>
+#include <ats/io/parser/fix_md_incremental_refresh.hpp>
+
+namespace ats
+{
+	// Replays a raw FIX log (one message per line) of MarketDataIncrementalRefresh messages, so that the
+	// log does not have to be converted into a CSV day file first (see fix_to_csv). Every packet holds the
+	// entries of a message for the symbol of the reader; messages without such entries are skipped
+	class fix_message_reader : public ats::exchange_message_reader_base<ats::level2_message_packet>
+	{
+	public:
+		fix_message_reader(const std::string& filename, const std::string& symbol, const std::string& exchange,
+				char delimiter = '\x01')
+			: ats::exchange_message_reader_base<ats::level2_message_packet>(),
+			  decoder_({ symbol }, exchange), delimiter_(delimiter)
+		{
+			message_.symbol_id = ats::symbol_registry().intern(symbol);
+			message_.exchange_id = ats::exchange_registry().intern(exchange);
+
+			// Like std::ifstream, a missing or empty file is simply a file without messages
+			boost::system::error_code ec;
+			uintmax_t size = boost::filesystem::file_size(filename, ec);
+			if (!ec && size > 0)
+			{
+				file_.open(filename);
+				pos_ = file_.data();
+				end_ = pos_ + file_.size();
+			}
+		}
+
+		virtual bool read() override
+		{
+			while (pos_ < end_)
+			{
+				const char* eol = static_cast<const char*>(std::memchr(pos_, '\n', end_ - pos_));
+				if (eol == nullptr)
+					eol = end_;
+				const char* begin = pos_;
+				pos_ = eol < end_ ? eol + 1 : end_;
+
+				if (eol > begin && eol[-1] == '\r')
+					--eol;
+				if (decoder_.decode(begin, eol, message_, delimiter_) && !message_.messages.empty())
+					return true;
+			}
+
+			message_.messages.clear();
+			return false;
+		}
+
+	private:
+		boost::iostreams::mapped_file_source file_;  // memory-mapped FIX log
+		const char* pos_ = nullptr;                  // beginning of the next line
+		const char* end_ = nullptr;
+		ats::fix_md::incremental_refresh_decoder decoder_;
+		char delimiter_;                             // delimiter of fields (SOH in FIX logs)
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,142 @@
+#ifndef LEVEL2_BINARY_MESSAGE_READER_HPP
+#define LEVEL2_BINARY_MESSAGE_READER_HPP
+
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <ats/data_feed/historical/exchange_message_reader_base.hpp>
+#include <ats/message/level2_message.hpp>
+#include <ats/io/format/level2_binary_format.hpp>
+
+namespace ats
+{
+	// Replays a memory-mapped level2 day file in the binary format (see level2_binary_format.hpp).
+	// Nothing is parsed: every read copies fixed-width records into the packet's messages
+	class l2_binary_message_reader : public ats::exchange_message_reader_base<ats::level2_message_packet>
+	{
+	public:
+		l2_binary_message_reader(const std::string& filename, const std::string& symbol, const std::string& exchange)
+			: ats::exchange_message_reader_base<ats::level2_message_packet>()
+		{
+			message_.symbol_id = ats::symbol_registry().intern(symbol);
+			message_.exchange_id = ats::exchange_registry().intern(exchange);
+			entry_.symbol_id = message_.symbol_id;
+			entry_.exchange_id = message_.exchange_id;
+
+			open(filename);
+		}
+
+		virtual bool read() override
+		{
+			if (packet_ >= packet_count_)
+				return false;
+
+			load(message_);
+			return true;
+		}
+
+		// Packet times are known from the index, so that packets past the horizon are not even decoded
+		virtual size_t read_batch(ats::level2_message_packet* messages, size_t size, const ats::timestamp_t& horizon, bool& more) override
+		{
+			size_t count = 0;
+			for (; count < size; ++count)
+			{
+				if (packet_ >= packet_count_)
+				{
+					more = false;
+					break;
+				}
+				if (!(ats::timestamp_t(index_[packet_].time) < horizon))
+				{
+					load(message_);
+					break;
+				}
+				load(messages[count]);
+			}
+			return count;
+		}
+
+		// Seeks with the packet index of the file
+		virtual bool seek(const ats::timestamp_t& time) override
+		{
+			auto it = std::lower_bound(index_, index_ + packet_count_, time.nanoseconds(),
+				[](const l2_binary::packet_index& packet, int64_t t) { return packet.time < t; });
+			packet_ = it - index_;
+			return true;
+		}
+
+		// Records of the last read packet, pointing straight into the mapped file
+		const l2_binary::record* begin_records() const
+		{
+			return packet_ > 0 ? records_ + index_[packet_ - 1].first_record : records_;
+		}
+
+		const l2_binary::record* end_records() const
+		{
+			return packet_ > 0 ? records_ + index_[packet_].first_record : records_;
+		}
+
+		size_t packet_count() const { return packet_count_; }
+
+	private:
+		// Decodes the next packet into message
+		void load(ats::level2_message_packet& message)
+		{
+			const l2_binary::packet_index& packet = index_[packet_];
+			size_t count = index_[packet_ + 1].first_record - packet.first_record;
+
+			message.time = ats::timestamp_t(packet.time);
+
+			// Messages are overwritten in place, so that the vector never reallocates once it has grown
+			auto& messages = message.messages;
+			messages.resize(count, entry_);
+			const l2_binary::record* r = records_ + packet.first_record;
+			for (auto& m : messages)
+			{
+				l2_binary::from_record(*r++, m);
+				m.time = message.time;
+			}
+
+			++packet_;
+		}
+
+		void open(const std::string& filename)
+		{
+			// Like the CSV readers, a missing or empty file is simply a file without messages
+			boost::system::error_code ec;
+			uintmax_t size = boost::filesystem::file_size(filename, ec);
+			if (ec || size == 0)
+				return;
+
+			file_.open(filename);
+
+			const char* data = file_.data();
+			l2_binary::file_header header;
+			if (size < sizeof(header))
+				throw std::runtime_error("l2_binary_message_reader: File '" + filename + "' is truncated");
+			std::memcpy(&header, data, sizeof(header));
+
+			if (!l2_binary::is_valid(header))
+				throw std::runtime_error("l2_binary_message_reader: File '" + filename + "' has unknown format");
+			if (header.records_offset + header.record_count * sizeof(l2_binary::record) > size ||
+				header.index_offset + (header.packet_count + 1) * sizeof(l2_binary::packet_index) > size)
+				throw std::runtime_error("l2_binary_message_reader: File '" + filename + "' is truncated");
+
+			records_ = reinterpret_cast<const l2_binary::record*>(data + header.records_offset);
+			index_ = reinterpret_cast<const l2_binary::packet_index*>(data + header.index_offset);
+			packet_count_ = header.packet_count;
+		}
+
+	private:
+		boost::iostreams::mapped_file_source file_;   // memory-mapped binary day file
+		const l2_binary::record* records_ = nullptr;
+		const l2_binary::packet_index* index_ = nullptr;
+		size_t packet_count_ = 0;
+		size_t packet_ = 0;                           // index of the next packet to read
+		ats::level2_message entry_;                   // prototype for newly grown packet entries
+	};
+}
+
+#endif
\ No newline at end of file
@@ -20,10 +20,19 @@ namespace ats
 		{
 			if (reader_.read(fields_))
 			{
-				message_.symbol = fields_[0];
-				message_.exchange = fields_[1];
+				// Lines of a file mostly share the symbol and exchange, which are only interned when they change
+				if (fields_[0] != symbol_)
+				{
+					symbol_ = fields_[0];
+					message_.symbol_id = ats::symbol_registry().intern(symbol_);
+				}
+				if (fields_[1] != exchange_)
+				{
+					exchange_ = fields_[1];
+					message_.exchange_id = ats::exchange_registry().intern(exchange_);
+				}
 				message_.seq_number = std::strtol(fields_[2].c_str(), nullptr, 10);
-				message_.time.parse(fields_[3], "%Y%m%d %H%M%S%F"); //= 0; // Time!!!!!!!!!!!!!!!
+				time_parser_.parse(fields_[3], message_.time);
 				message_.update_action = static_cast<ats::update_action>(std::strtol(fields_[4].c_str(), nullptr, 10));
 				message_.entry_type = static_cast<ats::entry_type>(std::strtol(fields_[5].c_str(), nullptr, 10));
 				message_.price = std::strtol(fields_[6].c_str(), nullptr, 10);
@@ -40,6 +49,8 @@ namespace ats
 		std::ifstream stream_;                // file containing messages
 		ats::csv_reader<10> reader_;          // reads fields of CSV files line by line
 		std::array<std::string, 10> fields_;  // fields of a line in our CSV file
+		ats::date_time::timestamp_parser time_parser_;  // parses timestamps, caching the date of the file
+		std::string symbol_, exchange_;       // names of the last message
 	};
 }
 
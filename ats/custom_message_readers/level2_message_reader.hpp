@@ -19,11 +19,23 @@ namespace ats
 			: ats::exchange_message_reader_base<ats::level2_message_packet>(),
 			stream_(filename)
 		{
-				message_.symbol = symbol;
-				message_.exchange = exchange;
+				message_.symbol_id = ats::symbol_registry().intern(symbol);
+				message_.exchange_id = ats::exchange_registry().intern(exchange);
 			}
 
 		virtual bool read() override
+		{
+			return read_one();
+		}
+
+		virtual size_t read_batch(ats::level2_message_packet* messages, size_t size, const ats::timestamp_t& horizon, bool& more) override
+		{
+			return read_batch_with([this]() { return read_one(); }, messages, size, horizon, more);
+		}
+
+	private:
+		// Reads the next packet into message_
+		bool read_one()
 		{
 			message_.messages.clear();
 			ats::level2_message msg;
@@ -40,10 +52,10 @@ namespace ats
 
 				if (!is_message)
 				{
-					message_.time.parse(fields_[0], "%Y%m%d %H%M%S%F");
+					time_parser_.parse(fields_[0], message_.time);
 					msg.time = message_.time;
-					msg.symbol = message_.symbol;
-					msg.exchange = message_.exchange;
+					msg.symbol_id = message_.symbol_id;
+					msg.exchange_id = message_.exchange_id;
 					is_message = true;
 				}
 
@@ -78,6 +90,7 @@ namespace ats
 		std::ifstream stream_;                // file containing messages
 		std::array<std::string, 7U> fields_;  // fields of a line in our CSV file
 		std::string line_;
+		ats::date_time::timestamp_parser time_parser_;  // parses timestamps, caching the date of the file
 	};
 }
 
@@ -0,0 +1,178 @@
+#ifndef LEVEL2_MMAP_MESSAGE_READER_HPP
+#define LEVEL2_MMAP_MESSAGE_READER_HPP
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <cctype>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <ats/data_feed/historical/exchange_message_reader_base.hpp>
+#include <ats/message/level2_message.hpp>
+#include <ats/io/tokenize.hpp>
+#include <ats/io/format/level2_time_index.hpp>
+
+namespace ats
+{
+	// Drop-in replacement for ats::l2_message_reader that memory-maps the CSV day file and
+	// tokenizes lines into string views, so that reading a line performs no heap allocations
+	class l2_mmap_message_reader : public ats::exchange_message_reader_base<ats::level2_message_packet>
+	{
+	public:
+		l2_mmap_message_reader(const std::string& filename, const std::string& symbol, const std::string& exchange)
+			: ats::exchange_message_reader_base<ats::level2_message_packet>(), filename_(filename)
+		{
+			message_.symbol_id = ats::symbol_registry().intern(symbol);
+			message_.exchange_id = ats::exchange_registry().intern(exchange);
+			entry_.symbol_id = message_.symbol_id;
+			entry_.exchange_id = message_.exchange_id;
+
+			// Like std::ifstream, a missing or empty file is simply a file without messages
+			boost::system::error_code ec;
+			uintmax_t size = boost::filesystem::file_size(filename, ec);
+			if (!ec && size > 0)
+			{
+				file_.open(filename);
+				pos_ = file_.data();
+				end_ = pos_ + file_.size();
+			}
+		}
+
+		virtual bool read() override
+		{
+			return read_one();
+		}
+
+		virtual size_t read_batch(ats::level2_message_packet* messages, size_t size, const ats::timestamp_t& horizon, bool& more) override
+		{
+			return read_batch_with([this]() { return read_one(); }, messages, size, horizon, more);
+		}
+
+		// Seeks with the sidecar time index of the file (see level2_time_index.hpp), which is built and
+		// saved by the first seek if the file has no index yet
+		virtual bool seek(const ats::timestamp_t& time) override
+		{
+			if (!file_.is_open())
+				return true;
+
+			if (!has_index_)
+			{
+				if (!l2_time_index::load(filename_, index_))
+				{
+					index_ = build_time_index(filename_);
+					l2_time_index::save(filename_, index_);
+				}
+				has_index_ = true;
+			}
+
+			pos_ = file_.data() + l2_time_index::find(index_, time);
+			return true;
+		}
+
+		// Byte offset of the next line to read
+		size_t offset() const { return file_.is_open() ? pos_ - file_.data() : 0; }
+
+		// Scans a day file and returns its time index
+		static std::vector<l2_time_index::entry> build_time_index(const std::string& filename)
+		{
+			std::vector<l2_time_index::entry> entries;
+			l2_mmap_message_reader reader(filename, "", "");
+			for (size_t packet = 0; ; ++packet)
+			{
+				uint64_t offset = reader.offset();
+				if (!reader.read())
+					break;
+				if (packet % l2_time_index::stride == 0)
+					entries.push_back(l2_time_index::entry{ reader.message_.time.nanoseconds(), offset });
+			}
+			return entries;
+		}
+
+	private:
+		// Reads the next packet into message_
+		bool read_one()
+		{
+			message_.messages.clear();
+
+			bool is_message = false;
+			while (pos_ < end_)
+			{
+				const char* eol = static_cast<const char*>(std::memchr(pos_, '\n', end_ - pos_));
+				if (eol == nullptr)
+					eol = end_;
+				std::string_view line(pos_, eol - pos_);
+				pos_ = eol < end_ ? eol + 1 : end_;
+
+				if (ats::tokenize(line, fields_, ',') != fields_.size())
+					break;
+
+				if (!is_message)
+				{
+					time_parser_.parse(fields_[0].data(), fields_[0].size(), message_.time);
+					entry_.time = message_.time;
+					is_message = true;
+				}
+
+				if (fields_[1] == "N")
+					entry_.update_action = ats::update_action::New;
+				else if (fields_[1] == "C")
+					entry_.update_action = ats::update_action::Change;
+				else if (fields_[1] == "D")
+					entry_.update_action = ats::update_action::Delete;
+
+				if (fields_[2] == "B")
+					entry_.entry_type = ats::entry_type::Bid;
+				else if (fields_[2] == "A")
+					entry_.entry_type = ats::entry_type::Ask;
+				else if (fields_[2] == "T")
+					entry_.entry_type = ats::entry_type::Trade;
+
+				entry_.level = to_long(fields_[3]);
+				entry_.price = to_long(fields_[4]);
+				entry_.quantity = to_long(fields_[5]);
+				entry_.order_count = to_long(fields_[6]);
+
+				message_.messages.push_back(entry_);
+			}
+
+			return is_message;
+		}
+
+		// Parses a field the way std::stol does: leading spaces and a sign are allowed, trailing characters
+		// are ignored, and a field without digits or out of range throws
+		static long to_long(std::string_view field)
+		{
+			const char* first = field.data();
+			const char* last = first + field.size();
+			while (first < last && std::isspace(static_cast<unsigned char>(*first)))
+				++first;
+			if (first < last && *first == '+' && (last - first == 1 || first[1] != '-'))
+				++first;
+
+			long value = 0;
+			std::from_chars_result result = std::from_chars(first, last, value);
+			if (result.ec == std::errc::invalid_argument)
+				throw std::invalid_argument("l2_mmap_message_reader: Invalid number '" + std::string(field) + "'");
+			if (result.ec == std::errc::result_out_of_range)
+				throw std::out_of_range("l2_mmap_message_reader: Number out of range '" + std::string(field) + "'");
+			return value;
+		}
+
+	private:
+		std::string filename_;
+		boost::iostreams::mapped_file_source file_;  // memory-mapped file containing messages
+		const char* pos_ = nullptr;                  // beginning of the next line
+		const char* end_ = nullptr;
+		std::array<std::string_view, 7U> fields_;    // fields of a line in our CSV file
+		ats::date_time::timestamp_parser time_parser_;  // parses timestamps, caching the date of the file
+		ats::level2_message entry_;                  // entry being decoded, symbol and exchange set once
+		std::vector<l2_time_index::entry> index_;    // time index of the file, loaded by the first seek
+		bool has_index_ = false;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef MDP3_MESSAGE_READER_HPP
+#define MDP3_MESSAGE_READER_HPP
+
+#include <string>
+#include <ats/data_feed/historical/exchange_message_reader_base.hpp>
+#include <ats/message/level2_message.hpp>
+#include <ats/io/format/pcap.hpp>
+#include <ats/io/format/mdp3_sbe.hpp>
+
+namespace ats
+{
+	// Replays a pcap capture of a CME MDP 3.0 incremental channel (see mdp3_sbe.hpp) without converting
+	// it into FIX or CSV first. Every packet holds the entries of an MDP packet for the security of the
+	// reader; packets without such entries are skipped. The capture may hold both feeds A and B of the
+	// channel: packets are arbitrated by sequence number, i.e., packets not newer than the last one are
+	// dropped. A non-zero port restricts the replay to datagrams sent to that port
+	class mdp3_message_reader : public ats::exchange_message_reader_base<ats::level2_message_packet>
+	{
+	public:
+		mdp3_message_reader(const std::string& filename, const std::string& symbol, const std::string& exchange,
+				int32_t security_id, int64_t price_divisor, uint16_t port = 0)
+			: ats::exchange_message_reader_base<ats::level2_message_packet>(), capture_(filename),
+			  decoder_(security_id, price_divisor, symbol, exchange), port_(port)
+		{
+			message_.symbol_id = ats::symbol_registry().intern(symbol);
+			message_.exchange_id = ats::exchange_registry().intern(exchange);
+		}
+
+		virtual bool read() override
+		{
+			const char* payload;
+			size_t size;
+			uint16_t port;
+			while (capture_.next(payload, size, port))
+			{
+				if (port_ != 0 && port != port_)
+					continue;
+				if (size >= ats::mdp3::packet_header_size && has_packets_ &&
+					ats::mdp3::load<uint32_t>(payload) <= decoder_.seq_number())
+					continue;
+
+				bool is_valid = decoder_.decode(payload, size, message_);
+				has_packets_ = has_packets_ || is_valid;
+				if (is_valid && !message_.messages.empty())
+					return true;
+			}
+
+			message_.messages.clear();
+			return false;
+		}
+
+	private:
+		ats::pcap::udp_reader capture_;
+		ats::mdp3::decoder decoder_;
+		uint16_t port_;
+		bool has_packets_ = false;  // the decoder holds the sequence number of a packet
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef SPREAD_MESSAGE_READER_HPP
+#define SPREAD_MESSAGE_READER_HPP
+
+#include <string>
+#include <vector>
+#include <ats/data_feed/historical/exchange_message_reader_base.hpp>
+#include <ats/message/level2_message.hpp>
+#include <ats/io/transform/spread_synthesizer.hpp>
+
+namespace ats
+{
+	// Replays a synthetic spread (see spread_synthesizer) as a one-level book, without writing the spread
+	// into a file first. Every packet replaces the bid and/or the ask that changed at a merge step; BBO
+	// files have no sizes, so levels are shown with the given quantity
+	class spread_message_reader : public ats::exchange_message_reader_base<ats::level2_message_packet>
+	{
+	public:
+		spread_message_reader(const std::vector<ats::spread_leg>& legs, const std::string& symbol,
+				const std::string& exchange, long quantity = 1)
+			: ats::exchange_message_reader_base<ats::level2_message_packet>(), spread_(legs), quantity_(quantity)
+		{
+			message_.symbol_id = ats::symbol_registry().intern(symbol);
+			message_.exchange_id = ats::exchange_registry().intern(exchange);
+		}
+
+		virtual bool read() override
+		{
+			message_.messages.clear();
+
+			ats::spread_quote quote;
+			while (spread_.next(quote))
+			{
+				message_.time = quote.time;
+				update_level(ats::entry_type::Bid, quote, quote.bid, bid_, has_bid_);
+				update_level(ats::entry_type::Ask, quote, quote.ask, ask_, has_ask_);
+				if (!message_.messages.empty())
+					return true;
+			}
+			return false;
+		}
+
+	private:
+		void update_level(ats::entry_type entry_type, const ats::spread_quote& quote, long price, ats::price_t& last,
+				bool& has_level)
+		{
+			if (has_level && price == last)
+				return;
+
+			if (has_level)
+				add_message(ats::update_action::Delete, entry_type, quote, last);
+			add_message(ats::update_action::New, entry_type, quote, static_cast<ats::price_t>(price));
+
+			has_level = true;
+			last = static_cast<ats::price_t>(price);
+		}
+
+		void add_message(ats::update_action update_action, ats::entry_type entry_type, const ats::spread_quote& quote,
+				ats::price_t price)
+		{
+			message_.messages.emplace_back();
+			ats::level2_message& m = message_.messages.back();
+			m.time = quote.time;
+			m.symbol_id = message_.symbol_id;
+			m.exchange_id = message_.exchange_id;
+			m.seq_number = static_cast<size_t>(quote.seq_num);
+			m.update_action = update_action;
+			m.entry_type = entry_type;
+			m.price = price;
+			m.quantity = quantity_;
+			m.order_count = 1;
+			m.level = 1;
+		}
+
+	private:
+		ats::spread_synthesizer spread_;
+		long quantity_;                   // quantity of the synthetic levels
+		ats::price_t bid_ = 0, ask_ = 0;  // current synthetic levels
+		bool has_bid_ = false, has_ask_ = false;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+#ifndef ASYNC_MESSAGE_READER_HPP
+#define ASYNC_MESSAGE_READER_HPP
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <utility>
+#include "exchange_message_reader_base.hpp"
+
+namespace ats
+{
+	// Reads messages ahead on a background thread: the wrapped reader decodes messages into a bounded
+	// single-producer/single-consumer ring, and read() only takes the next decoded message off the ring.
+	// Decoding thus overlaps with the matching engine and strategy callbacks on the replay thread.
+	// Messages in the ring are swapped rather than copied, so that their storage is reused once the
+	// ring is warm. A side finding the ring empty (or full) spins for a while, then sleeps until the other
+	// side wakes it up, so that a stalled reader or a slow strategy does not keep a core busy
+	template<typename MessageT>
+	class async_message_reader : public ats::exchange_message_reader_base<MessageT>
+	{
+		using reader_ptr = std::unique_ptr<ats::exchange_message_reader_base<MessageT>>;
+	public:
+		async_message_reader(reader_ptr&& reader, size_t capacity = 256)
+			: ats::exchange_message_reader_base<MessageT>(), reader_(std::move(reader)),
+			ring_(capacity + 1)   // one slot is kept free to tell a full ring from an empty one
+		{
+			start();
+		}
+
+		virtual ~async_message_reader()
+		{
+			stop();
+		}
+
+		virtual bool read() override
+		{
+			size_t head = head_.load(std::memory_order_relaxed);
+			if (head == tail_.load(std::memory_order_acquire))
+			{
+				wait(reader_waiting_, [this, head]()
+				{
+					return head != tail_.load(std::memory_order_acquire) || done_.load(std::memory_order_acquire);
+				});
+
+				// The decoding thread sets done_ after publishing its last message
+				if (head == tail_.load(std::memory_order_acquire))
+				{
+					if (error_)
+						std::rethrow_exception(std::exchange(error_, nullptr));
+					return false;
+				}
+			}
+
+			std::swap(this->message_, ring_[head]);
+			head_.store(next(head), std::memory_order_release);
+			wake(decoder_waiting_);
+			return true;
+		}
+
+		// The background thread is stopped while the wrapped reader seeks; messages decoded ahead are
+		// dropped if the seek succeeds
+		virtual bool seek(const ats::timestamp_t& time) override
+		{
+			stop();
+			bool result = reader_->seek(time);
+			if (result)
+			{
+				head_.store(0, std::memory_order_relaxed);
+				tail_.store(0, std::memory_order_relaxed);
+				done_.store(false, std::memory_order_relaxed);
+				pending_ = false;
+				error_ = nullptr;
+			}
+			if (!done_.load(std::memory_order_relaxed))
+				start();
+			return result;
+		}
+
+	private:
+		void start()
+		{
+			stop_.store(false, std::memory_order_relaxed);
+			thread_ = std::thread(&async_message_reader::decode, this);
+		}
+
+		void stop()
+		{
+			stop_.store(true, std::memory_order_relaxed);
+			wake(decoder_waiting_);
+			if (thread_.joinable())
+				thread_.join();
+		}
+
+		// Runs on the background thread
+		void decode()
+		{
+			try
+			{
+				// The thread stops before decoding another message, so that a seek or the destructor does not
+				// wait for the ring to fill up. A message read but not yet published when the thread was
+				// stopped is published first once restarted
+				for (;;)
+				{
+					if (stop_.load(std::memory_order_relaxed))
+						return;
+					if (!pending_ && !reader_->read())
+						break;
+
+					pending_ = true;
+					size_t tail = tail_.load(std::memory_order_relaxed);
+					if (next(tail) == head_.load(std::memory_order_acquire))
+					{
+						wait(decoder_waiting_, [this, tail]()
+						{
+							return next(tail) != head_.load(std::memory_order_acquire) || stop_.load(std::memory_order_relaxed);
+						});
+						if (next(tail) == head_.load(std::memory_order_acquire))
+							return;
+					}
+
+					ring_[tail] = reader_->get_last_true_message();
+					tail_.store(next(tail), std::memory_order_release);
+					wake(reader_waiting_);
+					pending_ = false;
+				}
+			}
+			catch (...)
+			{
+				error_ = std::current_exception();
+			}
+			done_.store(true, std::memory_order_release);
+			wake(reader_waiting_);
+		}
+
+		// Spins until ready() holds, then sleeps until woken up by the other side. The fences of wait()
+		// and wake() order the waiting flag with the positions, so that either the waiting side sees the
+		// change or the other side sees the flag and notifies under the mutex
+		template<typename predicate_type>
+		void wait(std::atomic<bool>& waiting, predicate_type ready)
+		{
+			for (int i = 0; i < spin_count; ++i)
+			{
+				if (ready())
+					return;
+				std::this_thread::yield();
+			}
+
+			std::unique_lock<std::mutex> lock(mutex_);
+			waiting.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			condition_.wait(lock, ready);
+			waiting.store(false, std::memory_order_relaxed);
+		}
+
+		// To be called after changing what the other side waits for
+		void wake(std::atomic<bool>& waiting)
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (waiting.load(std::memory_order_relaxed))
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				condition_.notify_all();
+			}
+		}
+
+		size_t next(size_t i) const { return i + 1 == ring_.size() ? 0 : i + 1; }
+
+	private:
+		static constexpr int spin_count = 64;   // yields before a side goes to sleep
+
+		reader_ptr reader_;                // reader decoding messages on the background thread
+		std::vector<MessageT> ring_;       // decoded messages [head_, tail_)
+		std::atomic<size_t> head_{0};      // next message to read (written by the replay thread)
+		std::atomic<size_t> tail_{0};      // next slot to decode into (written by the decoding thread)
+		std::atomic<bool> done_{false};    // the wrapped reader has no more messages
+		std::atomic<bool> stop_{false};    // the background thread is to stop (seek or destruction)
+		bool pending_ = false;             // the wrapped reader holds a message not yet in the ring
+		std::exception_ptr error_;         // exception thrown by the wrapped reader, rethrown by read()
+		std::mutex mutex_;                 // guards sleeping on condition_
+		std::condition_variable condition_;
+		std::atomic<bool> reader_waiting_{false};   // the replay thread sleeps on an empty ring
+		std::atomic<bool> decoder_waiting_{false};  // the decoding thread sleeps on a full ring
+		std::thread thread_;
+	};
+}
+
+#endif
\ No newline at end of file
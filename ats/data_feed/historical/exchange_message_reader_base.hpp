@@ -1,38 +1,102 @@
-#ifndef EXCHANGE_MESSAGE_READER_BASE_HPP
-#define EXCHANGE_MESSAGE_READER_BASE_HPP
-
-#include <ats/portfolio/portfolio_base.hpp>
-#include "message_reader.hpp"
-
-namespace ats
-{
-	template<typename MessageT>
-	class exchange_message_reader_base : public ats::message_reader
-	{
-	public:
-		virtual ~exchange_message_reader_base() { }
-
-		virtual void send_message(ats::portfolio_base* universe) const override
-		{
-			const ats::instrument_message& msg = static_cast<const ats::instrument_message&>(message_);
-			ats::execution_engine* engine = universe->get_execution_engine(msg.exchange);
-			if (engine != nullptr)
-				engine->invoke(message_);//(static_cast<const MessageT&>(message_));
-		}
-
-		virtual const ats::message& get_last_message() const override
-		{
-			return static_cast<const ats::message&>(message_);
-		}
-
-		const MessageT& get_last_true_message() const
-		{
-			return message_;
-		}
-	
-	protected:
-		MessageT message_;
-	};
-}
-
+#ifndef EXCHANGE_MESSAGE_READER_BASE_HPP
+#define EXCHANGE_MESSAGE_READER_BASE_HPP
+
+#include <vector>
+#include <utility>
+#include <ats/portfolio/portfolio_base.hpp>
+#include "message_reader.hpp"
+
+namespace ats
+{
+	template<typename MessageT>
+	class exchange_message_reader_base : public ats::message_reader
+	{
+	public:
+		virtual ~exchange_message_reader_base() { }
+
+		virtual void send_message(ats::portfolio_base* universe) const override
+		{
+			const ats::instrument_message& msg = static_cast<const ats::instrument_message&>(message_);
+			ats::execution_engine* engine = universe->get_execution_engine(msg.exchange_id);
+			if (engine != nullptr)
+				engine->invoke(message_);//(static_cast<const MessageT&>(message_));
+		}
+
+		// Sends messages in batches: the execution engine is looked up once per call, and messages are
+		// read into a buffer with a single call to read_batch, which readers may implement without
+		// per-message virtual calls
+		virtual bool send_messages(ats::portfolio_base* universe, const ats::timestamp_t& horizon) override
+		{
+			const ats::instrument_message& msg = static_cast<const ats::instrument_message&>(message_);
+			ats::execution_engine* engine = universe->get_execution_engine(msg.exchange_id);
+			if (engine != nullptr)
+				engine->invoke(static_cast<const MessageT&>(message_));
+
+			// Symbol and exchange never change within a reader, so buffered messages start as copies
+			// of the last one and may then be swapped with it
+			if (batch_.empty())
+				batch_.resize(batch_size, message_);
+
+			bool more = true;
+			size_t count;
+			do
+			{
+				count = read_batch(batch_.data(), batch_.size(), horizon, more);
+				if (engine != nullptr)
+				{
+					for (size_t i = 0; i < count; ++i)
+						engine->invoke(static_cast<const MessageT&>(batch_[i]));
+				}
+			} while (more && count == batch_.size());
+
+			return more;
+		}
+
+		// Reads the messages following the last read message into messages[0, size), as long as they are
+		// earlier than the horizon, and returns their number. The first message that is not earlier than
+		// the horizon is left as the last read message; more is set to false at the end of the data
+		virtual size_t read_batch(MessageT* messages, size_t size, const ats::timestamp_t& horizon, bool& more)
+		{
+			return read_batch_with([this]() { return read(); }, messages, size, horizon, more);
+		}
+
+		virtual const ats::message& get_last_message() const override
+		{
+			return static_cast<const ats::message&>(message_);
+		}
+
+		const MessageT& get_last_true_message() const
+		{
+			return message_;
+		}
+	
+	protected:
+		// read_batch reading messages with read_one, which decodes the next message into message_ like
+		// read(); readers override read_batch with their non-virtual decoding function, so that a batch
+		// takes no virtual call per message
+		template<typename ReadT>
+		size_t read_batch_with(ReadT read_one, MessageT* messages, size_t size, const ats::timestamp_t& horizon, bool& more)
+		{
+			size_t count = 0;
+			while (count < size)
+			{
+				if (!read_one())
+				{
+					more = false;
+					break;
+				}
+				if (!(message_.time < horizon))
+					break;
+				std::swap(messages[count++], message_);
+			}
+			return count;
+		}
+
+		static const size_t batch_size = 64;
+
+		MessageT message_;
+		std::vector<MessageT> batch_;  // messages read by send_messages
+	};
+}
+
 #endif
\ No newline at end of file
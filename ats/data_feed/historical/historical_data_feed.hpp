@@ -3,8 +3,8 @@
 
 #include <memory>
 #include <vector>
-#include <map>
 #include <utility>
+#include <algorithm>
 #include "message_reader.hpp"
 #include <ats/data_feed/data_feed.hpp>
 #include <ats/message/message.hpp>
@@ -12,73 +12,228 @@
 
 namespace ats
 {
+	// Interval of time [begin, end)
+	struct time_window
+	{
+		ats::timestamp_t begin;
+		ats::timestamp_t end;
+	};
+
 	// Historical data feed that can feed messages from different sources
 	class historical_data_feed : public ats::data_feed
 	{
 		using msg_reader_ptr = std::shared_ptr<ats::message_reader>;
 	public:
 		historical_data_feed(ats::portfolio_base* universe)
-			: ats::data_feed(universe) { }
+			: ats::data_feed(universe), windows_{ { ats::timestamp_t::min(), ats::timestamp_t::max() } } { }
 
 		virtual ~historical_data_feed() { }
 
-		void add_message_reader(const msg_reader_ptr& reader) { readers_.push_back(reader); }
-		void add_message_reader(msg_reader_ptr&& reader) { readers_.push_back(std::move(reader)); }
+		// Readers are to be added before the replay starts
+		void add_message_reader(const msg_reader_ptr& reader)
+		{
+			readers_.push_back(reader);
+			resize();
+		}
+
+		void add_message_reader(msg_reader_ptr&& reader)
+		{
+			readers_.push_back(std::move(reader));
+			resize();
+		}
 /*		void add_message_reader(const ats::message_reader& reader)
 		{
 			readers_.push_back(std::make_shared<ats::message_reader>(reader));
 		}*/
 
+		// Restrict the replay to a set of time windows (all messages if there is none): readers seek to the
+		// beginning of every window (see message_reader::seek) and messages outside the windows are skipped.
+		// Windows are to be set before the replay starts
+		void set_time_windows(std::vector<ats::time_window> windows)
+		{
+			windows_.clear();
+			if (windows.empty())
+				windows_.push_back(ats::time_window{ ats::timestamp_t::min(), ats::timestamp_t::max() });
+
+			std::sort(windows.begin(), windows.end(),
+				[](const ats::time_window& x, const ats::time_window& y) { return x.begin < y.begin; });
+			for (const auto& window : windows)
+			{
+				if (!(window.begin < window.end))
+					continue;
+				if (!windows_.empty() && !(windows_.back().end < window.begin))
+					windows_.back().end = std::max(windows_.back().end, window.end);
+				else
+					windows_.push_back(window);
+			}
+			window_ = 0;
+			started_ = false;
+		}
+
 		// Read messages from historical data sources in a synchronized manner
 		bool read()
 		{
-			if (indices_.empty())
+			if (readers_.empty() || window_ >= windows_.size())
+				return false;
+
+			if (!started_)
+				start();
+			else
 			{
-				for (size_t i = 0; i < readers_.size(); ++i)
-				{
-					if (readers_[i]->read())
-					{
-						const ats::message& msg = readers_[i]->get_last_message();
-						indices_.insert(std::make_pair(msg.time, i));
-					}
-				}
+				advance(tree_[0]);
+				replay();
 			}
-			else
+
+			return in_window();
+		}
+
+		// Send message to the associated trading universe
+		void send_message()
+		{
+			if (started_ && window_ < windows_.size())
+				readers_[tree_[0]]->send_message(this->universe_);
+		}
+
+		// Read and send all messages in the historical data feed. Messages are sent in batches: the reader
+		// with the earliest message sends all its messages up to the first message of another reader
+		void run()
+		{
+			if (!read())
+				return;
+
+			do
 			{
-				size_t i = indices_.begin()->second;
-				indices_.erase(indices_.begin());
-				if (readers_[i]->read())
+				size_t winner = tree_[0];
+				ats::timestamp_t end = std::min(horizon(winner), windows_[window_].end);
+				active_[winner] = readers_[winner]->send_messages(this->universe_, end);
+				if (active_[winner])
+					keys_[winner] = readers_[winner]->get_last_message().time;
+				replay();
+			} while (in_window());
+		}
+
+	private:
+		// Messages are merged with a loser tree over the readers: tree_[0] holds the reader with the
+		// earliest message, internal nodes 1..n-1 hold the readers that lost the match played there and
+		// reader i is the leaf n + i. Replacing the message of the winner replays the matches on the path
+		// from its leaf to the root only, i.e., log(n) comparisons and no allocations per message.
+		// Ties are broken by the reader index, so the merge order does not depend on the read order
+		void resize()
+		{
+			keys_.resize(readers_.size());
+			active_.resize(readers_.size());
+			tree_.resize(readers_.size());
+			window_ = 0;
+			started_ = false;
+		}
+
+		// Starts the replay of the current time window: readers seek to its beginning and skip the
+		// messages before it. Readers that cannot seek continue from their last read message
+		void start()
+		{
+			const ats::time_window& window = windows_[window_];
+			for (size_t i = 0; i < readers_.size(); ++i)
+			{
+				bool seek = window.begin > ats::timestamp_t::min() && readers_[i]->seek(window.begin);
+				if (seek || !started_)
+					advance(i);
+				while (active_[i] && keys_[i] < window.begin)
+					advance(i);
+			}
+			tree_[0] = build(1);
+			started_ = true;
+		}
+
+		// Moves on to the next time windows while the earliest message is past the end of the current one.
+		// Returns false once there are no more messages in the windows
+		bool in_window()
+		{
+			while (!active_[tree_[0]] || !(keys_[tree_[0]] < windows_[window_].end))
+			{
+				if (!active_[tree_[0]] || ++window_ == windows_.size())
 				{
-					const ats::message& msg = readers_[i]->get_last_message();
-					indices_.insert(std::make_pair(msg.time, i));
+					window_ = windows_.size();
+					return false;
 				}
+				start();
 			}
+			return true;
+		}
 
-			return !indices_.empty();
+		// Reads the next message of reader i and caches its time
+		void advance(size_t i)
+		{
+			active_[i] = readers_[i]->read();
+			if (active_[i])
+				keys_[i] = readers_[i]->get_last_message().time;
 		}
 
-		// Send message to the associated trading universe
-		void send_message()
+		// Whether the message of reader i is to be sent before the message of reader j
+		bool precedes(size_t i, size_t j) const
+		{
+			if (!active_[i] || !active_[j])
+				return active_[i];
+			return keys_[i] < keys_[j] || (keys_[i] == keys_[j] && i < j);
+		}
+
+		// Plays the matches of the subtree rooted at node and returns its winner
+		size_t build(size_t node)
+		{
+			size_t n = readers_.size();
+			if (node >= n)
+				return node - n;
+
+			size_t left = build(2 * node);
+			size_t right = build(2 * node + 1);
+			if (precedes(left, right))
+			{
+				tree_[node] = right;
+				return left;
+			}
+			tree_[node] = left;
+			return right;
+		}
+
+		// Time up to which messages of the winner are sent before those of other readers, that is, the time
+		// of the earliest message of the other readers (a tie goes to the reader with the lower index)
+		ats::timestamp_t horizon(size_t winner) const
 		{
-			if (!indices_.empty())
+			// The runner-up is one of the readers the winner has beaten on its way to the root
+			size_t runner_up = readers_.size();
+			for (size_t node = (winner + readers_.size()) / 2; node > 0; node /= 2)
 			{
-				size_t i = indices_.begin()->second;
-				readers_[i]->send_message(this->universe_);
+				size_t i = tree_[node];
+				if (active_[i] && (runner_up == readers_.size() || precedes(i, runner_up)))
+					runner_up = i;
 			}
+
+			if (runner_up == readers_.size())
+				return ats::timestamp_t::max();
+			if (winner < runner_up)
+				return keys_[runner_up] + ats::timestamp_t::duration(1);
+			return keys_[runner_up];
 		}
 
-		// Read and send all messages in the historical data feed
-		void run()
+		// Replays the matches on the path of the winner after its message has been replaced
+		void replay()
 		{
-			while (read())
+			size_t winner = tree_[0];
+			for (size_t node = (winner + readers_.size()) / 2; node > 0; node /= 2)
 			{
-				send_message();
+				if (precedes(tree_[node], winner))
+					std::swap(tree_[node], winner);
 			}
+			tree_[0] = winner;
 		}
 
 	private:
 		std::vector<msg_reader_ptr> readers_;
-		std::multimap<ats::timestamp_t, size_t> indices_;
+		std::vector<ats::timestamp_t> keys_;  // time of the last message of every reader
+		std::vector<char> active_;            // whether the reader still has a message to send
+		std::vector<size_t> tree_;            // loser tree (see above)
+		std::vector<ats::time_window> windows_;  // disjoint time windows to replay, in order
+		size_t window_ = 0;                   // current time window
+		bool started_ = false;
 	};
 }
 
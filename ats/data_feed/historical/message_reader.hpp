@@ -17,6 +17,21 @@ namespace ats
 		// Send message to a multi-event handler
 		virtual void send_message(ats::portfolio_base* universe) const = 0;
 
+		// Send the last read message, then read and send the following messages as long as they are earlier
+		// than the horizon. Returns true if reading stopped at a message that is not earlier than the horizon
+		// (it becomes the last read message, to be sent later) and false at the end of the data
+		virtual bool send_messages(ats::portfolio_base* universe, const ats::timestamp_t& horizon)
+		{
+			send_message(universe);
+			while (read())
+			{
+				if (!(get_last_message().time < horizon))
+					return true;
+				send_message(universe);
+			}
+			return false;
+		}
+
 		template<typename CallableT>
 		void send(CallableT& f)
 		{
@@ -25,6 +40,10 @@ namespace ats
 
 		// The last read message casted to the base class type
 		virtual const ats::message& get_last_message() const = 0;
+
+		// Position the reader so that reading continues with the first message at or after time (or with
+		// a somewhat earlier message). Returns false if the reader cannot seek, in which case it is left as is
+		virtual bool seek(const ats::timestamp_t& time) { return false; }
 	};
 
 	template<typename MessageT>
@@ -0,0 +1,33 @@
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include <ats/date_time/timestamp.hpp>
+
+namespace ats {
+namespace date_time
+{
+	// Time as seen by a portfolio or an engine: the time of the latest message while replaying (i.e.,
+	// simulated time), the system clock when trading in real time. Orders are stamped with now(), so that
+	// backtests do not read the system clock and are reproducible
+	class clock
+	{
+	public:
+		explicit clock(bool is_real_time = false) : is_real_time_(is_real_time) { }
+
+		timestamp now() const { return is_real_time_ ? timestamp::now() : time_; }
+
+		// Time of the latest message
+		const timestamp& time() const { return time_; }
+		void update(const timestamp& time) { time_ = time; }
+
+		bool is_real_time() const { return is_real_time_; }
+		void set_real_time(bool is_real_time) { is_real_time_ = is_real_time; }
+
+	private:
+		timestamp time_;
+		bool is_real_time_;
+	};
+}
+}
+
+#endif
\ No newline at end of file
@@ -3,11 +3,89 @@
 
 #include <string>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
 
 namespace ats {
 namespace date_time {
+	namespace detail
+	{
+		inline bool is_digits(const char* str, size_t length)
+		{
+			for (size_t i = 0; i < length; ++i)
+				if (str[i] < '0' || str[i] > '9') return false;
+			return true;
+		}
+
+		inline long to_int(const char* str, size_t length)
+		{
+			long result = 0;
+			for (size_t i = 0; i < length; ++i)
+				result = result * 10 + (str[i] - '0');
+			return result;
+		}
+
+		// Parses the "%Y%m%d " prefix of a "%Y%m%d %H%M%S%F" string
+		inline bool parse_date(const char* str, size_t length, boost::gregorian::date& result)
+		{
+			if (length < 15 || str[8] != ' ' || !is_digits(str, 8))
+				return false;
+
+			long year = to_int(str, 4);
+			long month = to_int(str + 4, 2);
+			long day = to_int(str + 6, 2);
+			if (year < 1400 || year > 9999 || month < 1 || month > 12 || day < 1 ||
+				day > boost::gregorian::gregorian_calendar::end_of_month_day(year, month))
+				return false;
+
+			result = boost::gregorian::date(year, month, day);
+			return true;
+		}
+
+		// Parses "%H%M%S%F" (i.e., HHMMSS[.fff...]) into the number of time_duration ticks since
+		// midnight. Fractional digits beyond the resolution of time_duration are dropped, the same way
+		// as time_input_facet does it
+		inline bool parse_time_of_day(const char* begin, const char* end, int64_t& ticks)
+		{
+			if (end - begin < 6 || !is_digits(begin, 6))
+				return false;
+
+			long hour = to_int(begin, 2);
+			long min = to_int(begin + 2, 2);
+			long sec = to_int(begin + 4, 2);
+			long frac = 0;
+
+			const char* it = begin + 6;
+			if (it != end && *it == '.')
+			{
+				const long precision = boost::posix_time::time_duration::num_fractional_digits();
+				long digits = 0;
+				for (++it; it != end && *it >= '0' && *it <= '9'; ++it, ++digits)
+				{
+					if (digits < precision)
+						frac = frac * 10 + (*it - '0');
+				}
+				for (; digits < precision && digits > 0; ++digits)
+					frac *= 10;
+			}
+
+			ticks = (hour * 3600LL + min * 60LL + sec) * boost::posix_time::time_duration::ticks_per_second() + frac;
+			return true;
+		}
+
+		inline bool parse_time_of_day(const char* begin, const char* end, boost::posix_time::time_duration& result)
+		{
+			int64_t ticks;
+			if (!parse_time_of_day(begin, end, ticks))
+				return false;
+
+			result = boost::posix_time::time_duration(0, 0, 0, ticks);
+			return true;
+		}
+	}
+
 	class date_time
 	{
 	public:
@@ -107,75 +185,45 @@ namespace date_time {
 			date = ptime(*mit, date.time_of_day());
 		}*/
 
-		// Datetime string must have the format "%Y%m%d %H%M%S%F"
-		void parse_simple(const char* datetime)
+		// Datetime string must have the format "%Y%m%d %H%M%S%F". The fields are parsed with integer
+		// arithmetic; anything else (including invalid dates) is left to time_input_facet
+		void parse_simple(const char* datetime, size_t length)
 		{
-			char* stop;
-			long date = std::strtol(datetime, &stop, 10);
-			long day = date % 100;
-			date = (date - day) / 100;
-			long month = date % 100;
-			long year = (date - month) / 100;
-			boost::posix_time::ptime result(boost::gregorian::date(year, month, day));
-
-			long time = std::strtol(stop + 1, &stop, 10);
-			long sec = time % 100;
-			time = (time - sec) / 100;
-			long min = time % 100;
-			long hour = (time - min) / 100;
-
-			if (*stop == '.')
-			{
-				long frac_sec = std::strtol(stop + 1, nullptr, 10);
-				double frac = std::strtod(stop, nullptr);
-				long resolution = (double)frac_sec / frac;
-				frac_sec *= boost::posix_time::time_duration::ticks_per_second() / resolution;
-				result += boost::posix_time::time_duration(hour, min, sec, frac_sec);
-			}
+			boost::posix_time::time_duration time_of_day;
+			boost::gregorian::date date;
+			if (detail::parse_date(datetime, length, date) &&
+				detail::parse_time_of_day(datetime + 9, datetime + length, time_of_day))
+				datetime_ = boost::posix_time::ptime(date, time_of_day);
 			else
-				result += boost::posix_time::time_duration(hour, min, sec);
+				parse_facet(std::string(datetime, length).c_str(), "%Y%m%d %H%M%S%F");
+		}
 
-			datetime_ = result;
+		// Datetime string must have the format "%Y%m%d %H%M%S%F"
+		void parse_simple(const char* datetime)
+		{
+			parse_simple(datetime, std::strlen(datetime));
 		}
 
 		// Datetime string must have the format "%Y%m%d %H%M%S%F"
 		void parse_simple(const std::string& datetime)
 		{
-			parse_simple(datetime.c_str());
+			parse_simple(datetime.c_str(), datetime.size());
 		}
 
 		void parse(const char* datetime, const char* fmt = "%Y%m%d %H%M%S%F")
 		{
-			static boost::posix_time::time_input_facet* facet = nullptr;//new time_input_facet(format);
-			static std::stringstream ss;//(date_str);
-			if (facet == nullptr)
-			{
-				facet = new boost::posix_time::time_input_facet(1);
-				ss.imbue(std::locale(std::locale(), facet));   // ss.imbue(locale(ss.getloc(), facet));
-			}
-
-			facet->format(fmt);//.c_str());
-			ss.str(datetime);
-
-			ss >> datetime_;
-			ss.clear();
+			if (std::strcmp(fmt, "%Y%m%d %H%M%S%F") == 0)
+				parse_simple(datetime);
+			else
+				parse_facet(datetime, fmt);
 		}
 
 		void parse(const std::string& datetime, const std::string& format = "%Y%m%d %H%M%S%F")
 		{
-			static boost::posix_time::time_input_facet* facet = nullptr;//new time_input_facet(format);
-			static std::stringstream ss;//(date_str);
-			if (facet == nullptr)
-			{
-				facet = new boost::posix_time::time_input_facet(1);
-				ss.imbue(std::locale(std::locale(), facet));   // ss.imbue(locale(ss.getloc(), facet));
-			}
-
-			facet->format(format.c_str());
-			ss.str(datetime);
-
-			ss >> datetime_;
-			ss.clear();
+			if (format == "%Y%m%d %H%M%S%F")
+				parse_simple(datetime);
+			else
+				parse_facet(datetime.c_str(), format.c_str());
 		}
 
 		// Before applying this function, make sure that
@@ -196,14 +244,15 @@ namespace date_time {
 
 		std::string to_string(const char* fmt = "%Y-%m-%d %H:%M:%S.%f") const
 		{
-			static boost::posix_time::time_facet* facet = nullptr;//new time_input_facet(format);
-			static std::stringstream ss;
+			static thread_local boost::posix_time::time_facet* facet = nullptr;//new time_input_facet(format);
+			static thread_local std::stringstream ss;
 			if (facet == nullptr)
 			{
 				facet = new boost::posix_time::time_facet(fmt);
 				ss.imbue(std::locale(std::locale(), facet));   // ss.imbue(locale(ss.getloc(), facet));
 			}
 
+			facet->format(fmt);
 			ss.str("");
 			ss.clear();
 
@@ -219,6 +268,25 @@ namespace date_time {
 			return out;
 		}
 		
+	private:
+		// Parses a string of any format using time_input_facet
+		void parse_facet(const char* datetime, const char* fmt)
+		{
+			static thread_local boost::posix_time::time_input_facet* facet = nullptr;//new time_input_facet(format);
+			static thread_local std::stringstream ss;//(date_str);
+			if (facet == nullptr)
+			{
+				facet = new boost::posix_time::time_input_facet(1);
+				ss.imbue(std::locale(std::locale(), facet));   // ss.imbue(locale(ss.getloc(), facet));
+			}
+
+			facet->format(fmt);//.c_str());
+			ss.str(datetime);
+
+			ss >> datetime_;
+			ss.clear();
+		}
+
 	private:
 		boost::posix_time::ptime datetime_;
 	};
@@ -0,0 +1,249 @@
+#ifndef TIMESTAMP_HPP
+#define TIMESTAMP_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <chrono>
+#include <string>
+#include <ostream>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <ats/date_time/date_time.hpp>
+
+namespace ats {
+namespace date_time
+{
+	// Point in time as a number of nanoseconds since the Unix epoch (UTC). Comparisons and arithmetic
+	// are plain integer operations, which makes it the time type of messages, orders and the replay
+	// pipeline. date_time is only needed to parse and format times (i.e., at I/O boundaries)
+	class timestamp
+	{
+	public:
+		typedef int64_t rep;
+		typedef std::chrono::nanoseconds duration;
+
+		static constexpr rep ns_per_second = 1000000000LL;
+		static constexpr rep ns_per_day = 86400LL * ns_per_second;
+
+		constexpr timestamp() : ns_(not_a_date_time_) { }
+		explicit constexpr timestamp(rep nanoseconds) : ns_(nanoseconds) { }
+
+		explicit timestamp(const ats::date_time::date_time& datetime)
+		{
+			boost::posix_time::ptime time(datetime);
+			if (time.is_not_a_date_time())
+				ns_ = not_a_date_time_;
+			else if (time.is_pos_infinity())
+				ns_ = std::numeric_limits<rep>::max();
+			else if (time.is_neg_infinity())
+				ns_ = std::numeric_limits<rep>::min() + 1;
+			else
+				ns_ = (time - epoch()).ticks() * ns_per_tick();
+		}
+
+		// Parses a string (see date_time::parse)
+		timestamp(const std::string& datetime, const std::string& fmt = "%Y%m%d %H%M%S%F")
+			: timestamp(ats::date_time::date_time(datetime, fmt)) { }
+
+		// Earliest and latest representable times (the counterparts of Boost's infinities)
+		static constexpr timestamp min() { return timestamp(std::numeric_limits<rep>::min() + 1); }
+		static constexpr timestamp max() { return timestamp(std::numeric_limits<rep>::max()); }
+
+		// Returns current time in UTC
+		static timestamp now()
+		{
+			auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+			return timestamp(std::chrono::duration_cast<duration>(since_epoch).count());
+		}
+
+		bool is_not_a_date_time() const { return ns_ == not_a_date_time_; }
+
+		// Nanoseconds since the Unix epoch
+		rep nanoseconds() const { return ns_; }
+
+		// Midnight of the same day
+		timestamp start_of_day() const { return timestamp(ns_ - floor_mod(ns_, ns_per_day)); }
+		duration time_of_day() const { return duration(floor_mod(ns_, ns_per_day)); }
+
+		ats::date_time::date_time to_date_time() const
+		{
+			if (ns_ == not_a_date_time_)
+				return ats::date_time::date_time(boost::posix_time::not_a_date_time);
+			if (ns_ == std::numeric_limits<rep>::max())
+				return ats::date_time::date_time(boost::posix_time::pos_infin);
+			if (ns_ == std::numeric_limits<rep>::min() + 1)
+				return ats::date_time::date_time(boost::posix_time::neg_infin);
+
+			rep ticks = (ns_ - floor_mod(ns_, ns_per_tick())) / ns_per_tick();
+			return ats::date_time::date_time(epoch() + boost::posix_time::time_duration(0, 0, 0, ticks));
+		}
+
+		std::string to_string(const char* fmt = "%Y-%m-%d %H:%M:%S.%f") const
+		{
+			return to_date_time().to_string(fmt);
+		}
+
+		// Operators:
+		constexpr bool operator < (const timestamp& other) const { return ns_ < other.ns_; }
+		constexpr bool operator > (const timestamp& other) const { return ns_ > other.ns_; }
+		constexpr bool operator == (const timestamp& other) const { return ns_ == other.ns_; }
+		constexpr bool operator != (const timestamp& other) const { return ns_ != other.ns_; }
+		constexpr bool operator <= (const timestamp& other) const { return ns_ <= other.ns_; }
+		constexpr bool operator >= (const timestamp& other) const { return ns_ >= other.ns_; }
+
+		// Like with Boost's ptime, not-a-date-time and the infinities stay what they are when a duration
+		// is added, and times moved past min() or max() become them. The difference of times is
+		// duration::min() if either is not-a-date-time, and the largest duration of the sign of the
+		// difference if either is infinite
+		constexpr timestamp operator + (const duration& d) const { return add(d.count()); }
+		constexpr timestamp operator - (const duration& d) const
+		{
+			return d.count() == std::numeric_limits<rep>::min() ? add(std::numeric_limits<rep>::max()) : add(-d.count());
+		}
+		constexpr duration operator - (const timestamp& other) const
+		{
+			if (ns_ == not_a_date_time_ || other.ns_ == not_a_date_time_ || (is_infinity() && ns_ == other.ns_))
+				return duration::min();
+			if (ns_ == max().ns_ || other.ns_ == min().ns_)
+				return duration::max();
+			if (ns_ == min().ns_ || other.ns_ == max().ns_)
+				return -duration::max();
+			return duration(ns_ - other.ns_);
+		}
+		timestamp& operator += (const duration& d) { return *this = *this + d; }
+		timestamp& operator -= (const duration& d) { return *this = *this - d; }
+
+		friend std::ostream& operator << (std::ostream& out, const timestamp& time)
+		{
+			out << time.to_date_time();
+			return out;
+		}
+
+	private:
+		static const boost::posix_time::ptime& epoch()
+		{
+			static const boost::posix_time::ptime epoch_(boost::gregorian::date(1970, 1, 1));
+			return epoch_;
+		}
+
+		static constexpr rep ns_per_tick()
+		{
+			return ns_per_second / boost::posix_time::time_duration::ticks_per_second();
+		}
+
+		constexpr bool is_infinity() const { return ns_ == max().ns_ || ns_ == min().ns_; }
+
+		constexpr timestamp add(rep d) const
+		{
+			if (ns_ == not_a_date_time_ || is_infinity())
+				return *this;
+			if (d > 0 && ns_ > max().ns_ - d)
+				return max();
+			if (d < 0 && ns_ < min().ns_ - d)
+				return min();
+			return timestamp(ns_ + d);
+		}
+
+		static constexpr rep floor_mod(rep x, rep y)
+		{
+			return x % y < 0 ? x % y + y : x % y;
+		}
+
+		static constexpr rep not_a_date_time_ = std::numeric_limits<rep>::min();
+
+		rep ns_;
+	};
+
+	// Converts a Boost duration (e.g., a bar periodicity given by a strategy) into a timestamp duration
+	inline timestamp::duration to_duration(const boost::posix_time::time_duration& duration)
+	{
+		return timestamp::duration(duration.total_nanoseconds());
+	}
+
+	// Parser of "%Y%m%d %H%M%S%F" timestamps for readers of day files. A day file contains a single
+	// date, so the start of the day of the last timestamp is cached and, while the date stays the
+	// same, only the time of day is parsed. The result is identical to that of date_time::parse
+	class timestamp_parser
+	{
+	public:
+		void parse(const char* datetime, size_t length, timestamp& result)
+		{
+			int64_t ticks;
+			if (length >= 15 && std::memcmp(datetime, date_str_, sizeof(date_str_)) == 0 &&
+				detail::parse_time_of_day(datetime + 9, datetime + length, ticks))
+			{
+				result = date_ + timestamp::duration(ticks * ns_per_tick);
+				return;
+			}
+
+			ats::date_time::date_time time;
+			time.parse_simple(datetime, length);
+			result = timestamp(time);
+
+			boost::gregorian::date date;
+			if (detail::parse_date(datetime, length, date))
+			{
+				std::memcpy(date_str_, datetime, sizeof(date_str_));
+				date_ = timestamp(ats::date_time::date_time(date));
+			}
+		}
+
+		void parse(const std::string& datetime, timestamp& result)
+		{
+			parse(datetime.c_str(), datetime.size(), result);
+		}
+
+	private:
+		static constexpr int64_t ns_per_tick = timestamp::ns_per_second / boost::posix_time::time_duration::ticks_per_second();
+
+		char date_str_[9] = { };  // cached "%Y%m%d " prefix
+		timestamp date_;          // midnight of that date
+	};
+
+	// Formatter of "%Y%m%d %H%M%S.%f" timestamps for writers of day files, the counterpart of
+	// timestamp_parser: the date of the last timestamp is cached and the time of day is formatted
+	// without streams. The result is identical to that of to_string("%Y%m%d %H%M%S.%f")
+	class timestamp_formatter
+	{
+	public:
+		// Writes the 22 characters of the time into out and returns the end of them
+		char* format(const timestamp& time, char* out)
+		{
+			int64_t ns = time.nanoseconds();
+			int64_t day = ns / timestamp::ns_per_day - (ns % timestamp::ns_per_day < 0 ? 1 : 0);
+			if (day != day_ || date_str_.empty())
+			{
+				day_ = day;
+				date_str_ = boost::gregorian::to_iso_string(boost::gregorian::date(1970, 1, 1) + boost::gregorian::days(day));
+			}
+
+			std::memcpy(out, date_str_.data(), date_str_.size());
+			out += date_str_.size();
+			*out++ = ' ';
+
+			int64_t us = (ns - day * timestamp::ns_per_day) / 1000;
+			int64_t seconds = us / 1000000;
+			out = digits(seconds / 3600, 2, out);
+			out = digits(seconds / 60 % 60, 2, out);
+			out = digits(seconds % 60, 2, out);
+			*out++ = '.';
+			return digits(us % 1000000, 6, out);
+		}
+
+	private:
+		static char* digits(int64_t value, int count, char* out)
+		{
+			for (int i = count - 1; i >= 0; --i, value /= 10)
+				out[i] = static_cast<char>('0' + value % 10);
+			return out + count;
+		}
+
+	private:
+		int64_t day_ = 0;
+		std::string date_str_;
+	};
+}
+}
+
+#endif
\ No newline at end of file
@@ -2,19 +2,36 @@
 
 namespace ats
 {
-	void level2_execution_engine::send_order(const ats::limit_order& order)
+	template<typename book_type>
+	void basic_level2_execution_engine<book_type>::send_order(const ats::limit_order& order)
 	{
-		auto it = sim_books_.find(order.symbol());
-		if (it != sim_books_.cend())
+		auto it = sim_books_.find(order.symbol_id());
+		if (it == sim_books_.cend())
+			return;
+
+		// Fills are reported at the time of the order. Orders sent past a portfolio may have no time:
+		// they are given the time of the engine, and rejected until the engine has received a message
+		if (!order.transact_time.is_not_a_date_time())
 		{
 			add_order(order);
 			it->second.add_order(order);
 		}
+		else if (!current_time().is_not_a_date_time())
+		{
+			ats::limit_order stamped(order);
+			stamped.transact_time = current_time();
+			add_order(stamped);
+			it->second.add_order(stamped);
+		}
+		else
+			on_order_status_changed(ats::order_status_rejected_message(order.id(), current_time(),
+					"level2_execution_engine: No market data received yet"));
 	}
 
-	void level2_execution_engine::send_order(const ats::market_order& order)
+	template<typename book_type>
+	void basic_level2_execution_engine<book_type>::send_order(const ats::market_order& order)
 	{
-		auto it = sim_books_.find(order.symbol());
+		auto it = sim_books_.find(order.symbol_id());
 		const ats::exchange_order_book& book = it->second.get_order_book();
 
 		on_order_status_changed(ats::order_status_pending_new_message(order.id(), current_time()));
@@ -49,9 +66,10 @@ namespace ats
 		}
 	}
 
-	void level2_execution_engine::send_order(const ats::stop_order& order)
+	template<typename book_type>
+	void basic_level2_execution_engine<book_type>::send_order(const ats::stop_order& order)
 	{
-		auto it = sim_books_.find(order.symbol());
+		auto it = sim_books_.find(order.symbol_id());
 		const ats::exchange_order_book& book = it->second.get_order_book();
 
 		on_order_status_changed(ats::order_status_pending_new_message(order.id(), current_time()));
@@ -79,4 +97,7 @@ namespace ats
 			}
 		}
 	}
-}
+
+	template class basic_level2_execution_engine<ats::sim::fifo_exchange_order_book>;
+	template class basic_level2_execution_engine<ats::sim::tick_fifo_exchange_order_book>;
+}
\ No newline at end of file
@@ -7,23 +7,32 @@
 #include <memory>
 #include <utility>
 #include <typeindex>
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include <ats/io/format/book_snapshot.hpp>
 #include <ats/execution_engine/execution_engine.hpp>
 #include <ats/order_book/exchange_order_book.hpp>
-//#include <ats/order_book/simulation/fifo_exchange_order_book.hpp>
 #include <ats/order_book/simulation/fifo_exchange_order_book.hpp>
 #include <ats/order_book/simulation/sim_book.hpp>
+#include <ats/container/order_index.hpp>
+#include <ats/security/metainfo.hpp>
 #include <ats/handler_types.hpp>
 #include <ats/types.hpp>
 
 namespace ats
 {
-	class level2_execution_engine : public ats::execution_engine
+	// Simulates the queues of subscribed symbols in books of book_type: sim::fifo_exchange_order_book, whose
+	// levels are kept in maps, or sim::tick_fifo_exchange_order_book, whose levels are kept in ladders
+	// indexed by tick (see set_metainfo). Member functions are instantiated for both in the source file
+	template<typename book_type>
+	class basic_level2_execution_engine : public ats::execution_engine
 	{
+		template<typename> friend class basic_level2_sweep;
 	public:
-		level2_execution_engine(const std::string& name, size_t book_depth = 10U)
+		basic_level2_execution_engine(const std::string& name, size_t book_depth = 10U)
 			: ats::execution_engine(name, ats::subscription::Level2), book_depth_(book_depth)
 		{
-			add_event_handler(&level2_execution_engine::on_order_book_changed, this);
+			add_event_handler(&basic_level2_execution_engine::on_order_book_changed, this);
 		}
 
 		void add_order_book_changed_listener(const ats::order_book_changed_handler& handler)
@@ -31,14 +40,27 @@ namespace ats
 			order_book_changed_handler_ = handler;
 		}
 
-		void subscribe(const ats::symbol_key& symbol)
+		// Tick size of a symbol, to be set before the symbol is subscribed (i.e., before the engine is
+		// connected to a portfolio); symbols without one get the default metainfo
+		void set_metainfo(const std::string& symbol, const ats::metainfo& info)
 		{
-			auto it = sim_books_.find(symbol.to_string());
+			metainfos_[ats::symbol_registry().intern(symbol)] = info;
+		}
+
+		virtual void subscribe(const ats::symbol_key& symbol) override
+		{
+			auto info = metainfos_.find(symbol.id);
+			subscribe(symbol, info != metainfos_.cend() ? info->second : ats::metainfo());
+		}
+
+		void subscribe(const ats::symbol_key& symbol, const ats::metainfo& info)
+		{
+			auto it = sim_books_.find(symbol.id);
 			if (it == sim_books_.cend())
 			{
-				ats::sim::fifo_exchange_order_book sim_book(symbol, name(), book_depth_);
-				sim_book.add_order_status_listener(std::bind(&ats::level2_execution_engine::on_order_status_changed, this, std::placeholders::_1));
-				sim_books_.insert(std::make_pair(symbol.to_string(), std::move(sim_book)));
+				book_type sim_book(symbol, name(), book_depth_, info);
+				sim_book.add_order_status_listener(std::bind(&basic_level2_execution_engine::on_sim_order_status_changed, this, std::placeholders::_1));
+				sim_books_.insert(std::make_pair(symbol.id, std::move(sim_book)));
 			}
 			else
 			{
@@ -49,42 +71,115 @@ namespace ats
 
 		void on_order_book_changed(const ats::level2_message_packet& msg)
 		{
-			time_ = msg.time;
-
-			auto book_it = sim_books_.find(msg.symbol);
-			if (book_it == sim_books_.cend()) return;
+			book_type* book = begin_packet(msg);
+			if (book == nullptr) return;
 
 			for (const auto& m : msg.messages)
-				book_it->second.update(m);
+				book->update(m);
 
-			// Check if stop orders must be executed
-			const ats::exchange_order_book& book = book_it->second.get_order_book();
-			if (!stops_buy_.empty() && !book.asks().empty())
+			end_packet(msg, *book);
+		}
+
+		const ats::timestamp_t& current_time() const { return time_; }
+
+		const ats::exchange_order_book* get_order_book(ats::symbol_id_t symbol) const
+		{
+			auto it = sim_books_.find(symbol);
+			return it != sim_books_.cend() ? &it->second.get_order_book() : nullptr;
+		}
+
+		const ats::exchange_order_book* get_order_book(const std::string& symbol) const
+		{
+			return get_order_book(ats::symbol_registry().find(symbol));
+		}
+
+		// Snapshot of the engine (see book_snapshot.hpp): the books of subscribed symbols with their
+		// simulated queues, and the working limit and stop orders
+		void save_snapshot(std::ostream& out, const ats::timestamp_t& time) const
+		{
+			ats::book_snapshot::write_header(out, time);
+			ats::book_snapshot::write(out, time_);
+
+			// Books and orders are written sorted, so that equal states give equal snapshots
+			std::map<std::string, const book_type*> books;
+			for (const auto& book : sim_books_)
+				books.insert(std::make_pair(ats::symbol_registry().name(book.first), &book.second));
+			ats::book_snapshot::write(out, static_cast<uint64_t>(books.size()));
+			for (const auto& book : books)
 			{
-				ats::price_t ask = book.best_ask()->price;
-				for (auto it = stops_buy_.begin(); it != stops_buy_.end() && it->second.price() <= ask;)
+				ats::book_snapshot::write(out, book.first);
+				book.second->save(out);
+			}
+
+			std::map<ats::orderid_t, const ats::order*> orders;
+			for (const auto& order : orders_)
+				orders.insert(std::make_pair(order.first, order.second.get()));
+			ats::book_snapshot::write(out, static_cast<uint64_t>(orders.size()));
+			for (const auto& order : orders)
+			{
+				ats::book_snapshot::write(out, order.second->symbol());
+				if (order.second->compare(typeid(ats::limit_order)))
 				{
-					const ats::stop_order& order = it->second;
-					on_order_status_changed(ats::order_status_filled_message(order.id(), current_time(), ask, order.quantity()));
-					stops_buy_.erase(it++);
+					ats::book_snapshot::write(out, static_cast<uint8_t>(ats::order_type::Limit));
+					ats::book_snapshot::write_order(out, static_cast<const ats::limit_order&>(*order.second));
+				}
+				else
+				{
+					ats::book_snapshot::write(out, static_cast<uint8_t>(ats::order_type::Stop));
+					ats::book_snapshot::write_order(out, static_cast<const ats::stop_order&>(*order.second));
 				}
 			}
-			else if (!stops_sell_.empty() && !book.bids().empty())
+		}
+
+		// Restores a snapshot saved by an engine subscribed to the same symbols; returns the time of the
+		// snapshot, from which the replay is to continue
+		ats::timestamp_t load_snapshot(std::istream& in)
+		{
+			ats::timestamp_t time = ats::book_snapshot::read_header(in);
+			ats::book_snapshot::read(in, time_);
+
+			std::string symbol;
+			for (uint64_t n = ats::book_snapshot::read<uint64_t>(in); n > 0; --n)
 			{
-				ats::price_t bid = book.best_bid()->price;
-				for (auto it = stops_sell_.begin(); it != stops_sell_.end() && it->second.price() > bid;)
+				ats::book_snapshot::read(in, symbol);
+				auto it = sim_books_.find(ats::symbol_registry().find(symbol));
+				if (it == sim_books_.end())
+					throw std::invalid_argument("level2_execution_engine: Symbol '" + symbol + "' is not subscribed");
+				it->second.load(in);
+			}
+
+			orders_.clear();
+			stops_buy_.clear();
+			stops_sell_.clear();
+			for (uint64_t n = ats::book_snapshot::read<uint64_t>(in); n > 0; --n)
+			{
+				ats::book_snapshot::read(in, symbol);
+				if (ats::book_snapshot::read<uint8_t>(in) == static_cast<uint8_t>(ats::order_type::Limit))
+					add_order(ats::book_snapshot::read_order<ats::limit_order>(in, symbol));
+				else
 				{
-					const ats::stop_order& order = it->second;
-					on_order_status_changed(ats::order_status_filled_message(order.id(), current_time(), bid, order.quantity()));
-					stops_sell_.erase(it++);
+					ats::stop_order order = ats::book_snapshot::read_order<ats::stop_order>(in, symbol);
+					if (order.side() == ats::order_side::Buy || order.side() == ats::order_side::BuyCover)
+						stops_buy_.insert(std::make_pair(order.price(), order));
+					else
+						stops_sell_.insert(std::make_pair(order.price(), order));
+					add_order(order);
 				}
 			}
 
-			if (order_book_changed_handler_ != nullptr)
-				order_book_changed_handler_(msg);
+			next_snapshot_time_ = time;
+			return time;
 		}
 
-		const ats::timestamp_t& current_time() const { return time_; }
+		// Writes a snapshot into directory every period of market time, aligned on the start of the day,
+		// named "<engine name>_<YYYYMMDD>_<HHMMSS.ffffff>.snap" (see ats::book_snapshot::find). The first
+		// one is due at the end of the period of the first packet
+		void set_snapshot_period(const std::string& directory, const boost::posix_time::time_duration& period)
+		{
+			snapshot_directory_ = directory;
+			snapshot_period_ = ats::date_time::to_duration(period);
+			next_snapshot_time_ = ats::timestamp_t();
+		}
 
 		virtual void send_order(const ats::market_order& order) override;
 		virtual void send_order(const ats::limit_order& order) override;
@@ -97,11 +192,12 @@ namespace ats
 			auto it = orders_.find(order_id);
 			if (it != orders_.cend())
 			{
-				auto& order = it->second;
+				// A copy, since listeners called by the book may send orders, which moves the entries
+				std::shared_ptr<ats::order> order = it->second;
 				std::type_index order_type(typeid(*order.get()));
 				if (order_type == typeid(ats::limit_order))
 				{
-					auto book_it = sim_books_.find(order->symbol());
+					auto book_it = sim_books_.find(order->symbol_id());
 					book_it->second.cancel_order(order_id, current_time());
 				}
 				else if (order_type == typeid(ats::stop_order))
@@ -119,7 +215,7 @@ namespace ats
 					}
 				}
 
-				orders_.erase(it);
+				orders_.erase(order_id);
 				// For a limit order, on_order_status_changed will be called from inside the fifo_exchange_order_book
 				if (order_type == typeid(ats::stop_order))
 					on_order_status_changed(ats::order_status_cancelled_message(order_id, current_time()));
@@ -135,16 +231,116 @@ namespace ats
 			orders_.insert(std::make_pair(order.id(), std::make_shared<OrderT>(order)));
 		}
 
+		// orders_ only keeps working orders, so that snapshots do not grow with every order ever sent
+		void on_sim_order_status_changed(const ats::order_status_message& msg)
+		{
+			if (msg.order_status == ats::order_status::Filled || msg.order_status == ats::order_status::Canceled ||
+					msg.order_status == ats::order_status::Rejected)
+				orders_.erase(msg.order_id);
+			on_order_status_changed(msg);
+		}
+
+		// A packet is processed in three steps, so that a sweep (see ats::level2_sweep) can update the
+		// simulated books of its engines in between: begin_packet returns the simulated book of the symbol
+		// of the packet (nullptr if the symbol is not subscribed), end_packet executes stop orders and
+		// notifies the listener
+		book_type* begin_packet(const ats::level2_message_packet& msg)
+		{
+			// A snapshot holds the state before the first message at or after its time
+			if (snapshot_period_ != ats::timestamp_t::duration::zero())
+			{
+				if (next_snapshot_time_.is_not_a_date_time())
+					schedule_snapshot(msg.time);
+				else if (msg.time >= next_snapshot_time_)
+					write_snapshot(msg.time);
+			}
+
+			time_ = msg.time;
+
+			auto book_it = sim_books_.find(msg.symbol_id);
+			return book_it != sim_books_.end() ? &book_it->second : nullptr;
+		}
+
+		void end_packet(const ats::level2_message_packet& msg, const book_type& sim_book)
+		{
+			// Check if stop orders must be executed
+			const ats::exchange_order_book& book = sim_book.get_order_book();
+			if (!stops_buy_.empty() && !book.asks().empty())
+			{
+				ats::price_t ask = book.best_ask()->price;
+				for (auto it = stops_buy_.begin(); it != stops_buy_.end() && it->second.price() <= ask;)
+				{
+					ats::stop_order order = it->second;
+					stops_buy_.erase(it++);
+					orders_.erase(order.id());
+					on_order_status_changed(ats::order_status_filled_message(order.id(), current_time(), ask, order.quantity()));
+				}
+			}
+			else if (!stops_sell_.empty() && !book.bids().empty())
+			{
+				ats::price_t bid = book.best_bid()->price;
+				for (auto it = stops_sell_.begin(); it != stops_sell_.end() && it->second.price() > bid;)
+				{
+					ats::stop_order order = it->second;
+					stops_sell_.erase(it++);
+					orders_.erase(order.id());
+					on_order_status_changed(ats::order_status_filled_message(order.id(), current_time(), bid, order.quantity()));
+				}
+			}
+
+			if (order_book_changed_handler_ != nullptr)
+				order_book_changed_handler_(msg);
+		}
+
+		void write_snapshot(const ats::timestamp_t& time)
+		{
+			boost::filesystem::path path(snapshot_directory_);
+			std::string filename = (path / (name() + '_' + time.to_string("%Y%m%d_%H%M%S%F") + ".snap")).string();
+			// Written aside and renamed once complete, so that book_snapshot::find never picks a truncated file
+			boost::filesystem::path tmp(filename + ".tmp");
+			std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+			save_snapshot(out, time);
+			out.close();
+			boost::system::error_code ec;
+			if (out)
+				boost::filesystem::rename(tmp, filename, ec);
+			if (!out || ec)
+			{
+				boost::filesystem::remove(tmp, ec);
+				std::cout << "ERROR (level2_execution_engine): Cannot write snapshot '" << filename << "'\n";
+			}
+
+			schedule_snapshot(time);
+		}
+
+		// The next snapshot is due at the end of the current period
+		void schedule_snapshot(const ats::timestamp_t& time)
+		{
+			ats::timestamp_t::duration since_start = time - time.start_of_day();
+			next_snapshot_time_ = time.start_of_day() + (since_start / snapshot_period_ + 1) * snapshot_period_;
+		}
+
 	private:
 		size_t book_depth_;
-		std::unordered_map<std::string, ats::sim::fifo_exchange_order_book> sim_books_;
-		std::unordered_map<ats::orderid_t, std::shared_ptr<ats::order>> orders_;
+		std::unordered_map<ats::symbol_id_t, book_type> sim_books_;  // by interned symbol
+		std::unordered_map<ats::symbol_id_t, ats::metainfo> metainfos_;  // by interned symbol, see set_metainfo
+		ats::order_index<std::shared_ptr<ats::order>> orders_;
 		ats::timestamp_t time_;
 		ats::order_book_changed_handler order_book_changed_handler_ = nullptr;
 
+		std::string snapshot_directory_;
+		ats::timestamp_t::duration snapshot_period_ = ats::timestamp_t::duration::zero();
+		ats::timestamp_t next_snapshot_time_;
+
 		std::multimap<ats::price_t, ats::stop_order, std::less<ats::price_t>> stops_buy_;
 		std::multimap<ats::price_t, ats::stop_order, std::greater<ats::price_t>> stops_sell_;
 	};
+
+	typedef basic_level2_execution_engine<ats::sim::fifo_exchange_order_book> level2_execution_engine;
+	typedef basic_level2_execution_engine<ats::sim::tick_fifo_exchange_order_book> tick_level2_execution_engine;
+
+	extern template class basic_level2_execution_engine<ats::sim::fifo_exchange_order_book>;
+	extern template class basic_level2_execution_engine<ats::sim::tick_fifo_exchange_order_book>;
 }
 
 #endif
\ No newline at end of file
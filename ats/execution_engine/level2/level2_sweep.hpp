@@ -0,0 +1,145 @@
+#ifndef LEVEL2_SWEEP_HPP
+#define LEVEL2_SWEEP_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include "level2_execution_engine.hpp"
+
+namespace ats
+{
+	// Fans one level2 data stream out to the execution engines of several portfolios, e.g., instances of
+	// a strategy with different parameters in a parameter sweep. Packets are decoded once, and the
+	// exchange book of every symbol is updated once per message and shared by the engines, which only
+	// keep their own simulated queues and orders. Every instance still gets its own positions and orders.
+	//
+	// Only the books of the engines are shared: the securities of every instance keep their own order
+	// books, which their portfolio updates with every packet, so that this part of book maintenance is
+	// still paid once per instance.
+	//
+	// Engines restored from snapshots are to be added before the first packet: the shared book of a
+	// symbol is made from the book of the first engine subscribed to it, i.e., from its snapshot.
+	//
+	// The sweep is connected to a portfolio without securities, which is given to the data feed:
+	//
+	//   ats::level2_sweep sweep("CME");
+	//   for (auto& instance : instances)      // portfolios connected to their own level2_execution_engine
+	//       sweep.add_engine(&instance->engine);
+	//   ats::portfolio_base universe("sweep.log");
+	//   universe.add_connection(&sweep);
+	//   ats::historical_data_feed feed(&universe);
+	//
+	// The engines of a sweep keep their books in the same book_type (see basic_level2_execution_engine)
+	template<typename book_type>
+	class basic_level2_sweep : public ats::execution_engine
+	{
+		typedef ats::basic_level2_execution_engine<book_type> engine_type;
+	public:
+		basic_level2_sweep(const std::string& name)
+			: ats::execution_engine(name, ats::subscription::Level2)
+		{
+			add_event_handler(&basic_level2_sweep::on_order_book_changed, this);
+		}
+
+		// Engines are to be added before the replay starts
+		void add_engine(engine_type* engine)
+		{
+			if (engine->name() != name())
+			{
+				std::string text = "level2_sweep: Engine '" + engine->name() + "' doesn't trade on '" + name() + "'";
+				throw std::invalid_argument(text);
+			}
+			engines_.push_back(engine);
+			books_.resize(engines_.size());
+		}
+
+		const std::vector<engine_type*>& engines() const { return engines_; }
+
+		const ats::exchange_order_book* get_order_book(ats::symbol_id_t symbol) const
+		{
+			auto it = reference_books_.find(symbol);
+			return it != reference_books_.cend() ? &it->second : nullptr;
+		}
+
+		const ats::exchange_order_book* get_order_book(const std::string& symbol) const
+		{
+			return get_order_book(ats::symbol_registry().find(symbol));
+		}
+
+		void on_order_book_changed(const ats::level2_message_packet& msg)
+		{
+			ats::exchange_order_book* reference = nullptr;
+			for (size_t i = 0; i < engines_.size(); ++i)
+			{
+				books_[i] = engines_[i]->begin_packet(msg);
+				if (books_[i] != nullptr && reference == nullptr)
+					reference = &get_reference_book(*books_[i]);
+			}
+
+			// No engine is subscribed to the symbol
+			if (reference == nullptr) return;
+
+			for (size_t i = 0; i < engines_.size(); ++i)
+			{
+				if (books_[i] != nullptr)
+					books_[i]->set_reference_book(reference);
+			}
+
+			// Messages are applied one at a time, so that every engine sees the exchange book as it would
+			// have updated it itself
+			for (const auto& m : msg.messages)
+			{
+				ats::level2_message msg_delta = book_type::make_delta(*reference, m);
+				reference->update(m);
+				for (auto book : books_)
+				{
+					if (book != nullptr)
+						book->update_queues(msg_delta);
+				}
+			}
+
+			for (size_t i = 0; i < engines_.size(); ++i)
+			{
+				if (books_[i] != nullptr)
+					engines_[i]->end_packet(msg, *books_[i]);
+			}
+		}
+
+		// Symbols are subscribed by the engines of the instances
+		virtual void subscribe(const ats::symbol_key&) override { }
+
+		// Orders are sent by the instances to their own engines
+		virtual void send_order(const ats::market_order&) override { reject_order(); }
+		virtual void send_order(const ats::limit_order&) override { reject_order(); }
+		virtual void send_order(const ats::stop_order&) override { reject_order(); }
+		virtual void cancel_order(const ats::orderid_t&) override { reject_order(); }
+
+	private:
+		// The shared book is a copy of the book of the first engine subscribed to the symbol, which is
+		// empty unless the engine has been restored from a snapshot
+		ats::exchange_order_book& get_reference_book(const book_type& book)
+		{
+			const ats::exchange_order_book& engine_book = book.get_order_book();
+			auto it = reference_books_.find(engine_book.symbol().id);
+			if (it == reference_books_.end())
+				it = reference_books_.insert(std::make_pair(engine_book.symbol().id, engine_book)).first;
+			return it->second;
+		}
+
+		void reject_order() const
+		{
+			throw std::invalid_argument("level2_sweep: Orders are to be sent to the engines of the sweep");
+		}
+
+	private:
+		std::vector<engine_type*> engines_;
+		std::vector<book_type*> books_;  // books of the engines for the current packet
+		std::unordered_map<ats::symbol_id_t, ats::exchange_order_book> reference_books_;  // shared books by symbol
+	};
+
+	typedef basic_level2_sweep<ats::sim::fifo_exchange_order_book> level2_sweep;
+	typedef basic_level2_sweep<ats::sim::tick_fifo_exchange_order_book> tick_level2_sweep;
+}
+
+#endif
\ No newline at end of file
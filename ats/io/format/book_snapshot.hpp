@@ -0,0 +1,176 @@
+#ifndef BOOK_SNAPSHOT_HPP
+#define BOOK_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <boost/filesystem.hpp>
+#include <ats/order/limit_order.hpp>
+#include <ats/order/stop_order.hpp>
+#include <ats/types.hpp>
+
+namespace ats {
+namespace book_snapshot
+{
+	// Binary snapshots of order books (see the save and load functions of exchange_order_book,
+	// sim::sim_book and level2_execution_engine). A snapshot file is
+	//
+	//   file_header | engine state
+	//
+	// where every book writes its fields in a fixed order: integers in the byte order of the host,
+	// strings as a 32-bit length followed by the characters, and collections as a 64-bit count
+	// followed by the elements. Snapshot files are meant to be read on the machine that wrote them
+
+	static const char file_magic[8] = { 'A', 'T', 'S', 'B', 'O', 'O', 'K', 'S' };
+	static const uint32_t file_version = 1;
+
+	struct file_header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t reserved;
+		int64_t time;  // time of the snapshot in nanoseconds since the Unix epoch
+	};
+
+	static_assert(sizeof(file_header) == 24, "book_snapshot::file_header must be 24 bytes");
+
+	template<typename T>
+	inline void write(std::ostream& out, const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "book_snapshot::write: T must be trivially copyable");
+		out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	template<typename T>
+	inline void read(std::istream& in, T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "book_snapshot::read: T must be trivially copyable");
+		if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)))
+			throw std::runtime_error("book_snapshot: Unexpected end of snapshot");
+	}
+
+	template<typename T>
+	inline T read(std::istream& in)
+	{
+		T value;
+		read(in, value);
+		return value;
+	}
+
+	inline void write(std::ostream& out, const std::string& value)
+	{
+		write(out, static_cast<uint32_t>(value.size()));
+		out.write(value.data(), value.size());
+	}
+
+	inline void read(std::istream& in, std::string& value)
+	{
+		value.resize(read<uint32_t>(in));
+		if (!in.read(&value[0], value.size()))
+			throw std::runtime_error("book_snapshot: Unexpected end of snapshot");
+	}
+
+	inline void write(std::ostream& out, const ats::timestamp_t& time)
+	{
+		write(out, time.nanoseconds());
+	}
+
+	inline void read(std::istream& in, ats::timestamp_t& time)
+	{
+		time = ats::timestamp_t(read<ats::timestamp_t::rep>(in));
+	}
+
+	inline void write_header(std::ostream& out, const ats::timestamp_t& time)
+	{
+		file_header header;
+		std::memcpy(header.magic, file_magic, sizeof(header.magic));
+		header.version = file_version;
+		header.reserved = 0;
+		header.time = time.nanoseconds();
+		write(out, header);
+	}
+
+	// Returns the time of the snapshot
+	inline ats::timestamp_t read_header(std::istream& in)
+	{
+		file_header header;
+		read(in, header);
+		if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != file_version)
+			throw std::runtime_error("book_snapshot: Unknown snapshot format");
+		return ats::timestamp_t(header.time);
+	}
+
+	// Returns the latest snapshot in directory written by the engine called name at or before time,
+	// or an empty string if there is none
+	inline std::string find(const std::string& directory, const std::string& name, const ats::timestamp_t& time)
+	{
+		std::string result;
+		ats::timestamp_t result_time;
+
+		boost::system::error_code ec;
+		boost::filesystem::directory_iterator it(directory, ec), end;
+		for (; !ec && it != end; it.increment(ec))
+		{
+			std::string filename = it->path().filename().string();
+			if (filename.compare(0, name.size() + 1, name + '_') != 0 || it->path().extension() != ".snap")
+				continue;
+
+			std::ifstream in(it->path().string(), std::ios::binary);
+			file_header header;
+			if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+				std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != file_version)
+				continue;
+
+			ats::timestamp_t snapshot_time(header.time);
+			if (snapshot_time <= time && (result.empty() || result_time < snapshot_time))
+			{
+				result = it->path().string();
+				result_time = snapshot_time;
+			}
+		}
+		return result;
+	}
+
+	// Orders are stored with every field needed to carry on with them after a restore. The symbol is
+	// passed by the book that stores the order, so that it is not repeated for every order
+	template<typename OrderT>
+	inline void write_order(std::ostream& out, const OrderT& order)
+	{
+		write(out, order.id());
+		write(out, static_cast<int64_t>(order.quantity()));
+		write(out, static_cast<uint8_t>(order.side()));
+		write(out, static_cast<uint8_t>(order.time_in_force()));
+		write(out, static_cast<int32_t>(order.price()));
+		write(out, static_cast<uint8_t>(order.status()));
+		write(out, static_cast<int64_t>(order.parent_id));
+		write(out, static_cast<int64_t>(order.executed_quantity));
+		write(out, order.transact_time);
+		write(out, order.exchange);
+	}
+
+	template<typename OrderT>
+	inline OrderT read_order(std::istream& in, const std::string& symbol)
+	{
+		ats::orderid_t id = read<ats::orderid_t>(in);
+		long quantity = read<int64_t>(in);
+		ats::order_side side = static_cast<ats::order_side>(read<uint8_t>(in));
+		ats::order_time_in_force time_in_force = static_cast<ats::order_time_in_force>(read<uint8_t>(in));
+		ats::price_t price = read<int32_t>(in);
+
+		OrderT order(id, symbol, quantity, side, time_in_force, price);
+		order.set_status(static_cast<ats::order_status>(read<uint8_t>(in)));
+		order.parent_id = read<int64_t>(in);
+		order.executed_quantity = read<int64_t>(in);
+		read(in, order.transact_time);
+		read(in, order.exchange);
+		return order;
+	}
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef LEVEL2_BINARY_FORMAT_HPP
+#define LEVEL2_BINARY_FORMAT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <ats/message/level2_message.hpp>
+#include <ats/types.hpp>
+
+namespace ats {
+namespace l2_binary
+{
+	// Layout of a level2 day file in the binary format:
+	//
+	//   file_header | record[record_count] | packet_index[packet_count + 1]
+	//
+	// Records of a packet are stored contiguously; the packet index holds the time of every packet
+	// and the position of its first record, with a sentinel entry closing the last packet.
+	// Integers are stored in the byte order of the host (the files are not meant to be portable).
+
+	static const char file_magic[8] = { 'A', 'T', 'S', 'L', '2', 'B', 'I', 'N' };
+	static const uint32_t file_version = 1;
+
+	struct file_header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t record_size;
+		uint64_t record_count;
+		uint64_t packet_count;
+		uint64_t records_offset;  // byte offset of the first record
+		uint64_t index_offset;    // byte offset of the first packet index entry
+	};
+
+	// Fixed-width incremental refresh entry
+	struct record
+	{
+		int32_t price;
+		int32_t quantity;
+		int32_t order_count;
+		uint16_t level;
+		uint8_t update_action;
+		uint8_t entry_type;
+	};
+
+	// Packet boundary: the packet owns records [first_record, next packet's first_record)
+	struct packet_index
+	{
+		int64_t time;           // nanoseconds since the Unix epoch
+		uint64_t first_record;
+	};
+
+	static_assert(sizeof(file_header) == 48, "l2_binary::file_header must be 48 bytes");
+	static_assert(sizeof(record) == 16, "l2_binary::record must be 16 bytes");
+	static_assert(sizeof(packet_index) == 16, "l2_binary::packet_index must be 16 bytes");
+
+	inline bool is_valid(const file_header& header)
+	{
+		return std::memcmp(header.magic, file_magic, sizeof(file_magic)) == 0 &&
+				header.version == file_version && header.record_size == sizeof(record);
+	}
+
+	inline record to_record(const ats::level2_message& msg)
+	{
+		record r;
+		r.price = static_cast<int32_t>(msg.price);
+		r.quantity = static_cast<int32_t>(msg.quantity);
+		r.order_count = static_cast<int32_t>(msg.order_count);
+		r.level = static_cast<uint16_t>(msg.level);
+		r.update_action = static_cast<uint8_t>(msg.update_action);
+		r.entry_type = static_cast<uint8_t>(msg.entry_type);
+		return r;
+	}
+
+	// Copies the fields of a record into a message (time, symbol and exchange are left untouched)
+	inline void from_record(const record& r, ats::level2_message& msg)
+	{
+		msg.price = r.price;
+		msg.quantity = r.quantity;
+		msg.order_count = r.order_count;
+		msg.level = r.level;
+		msg.update_action = static_cast<ats::update_action>(r.update_action);
+		msg.entry_type = static_cast<ats::entry_type>(r.entry_type);
+	}
+}
+}
+
+#endif
\ No newline at end of file
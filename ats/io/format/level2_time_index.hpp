@@ -0,0 +1,108 @@
+#ifndef LEVEL2_TIME_INDEX_HPP
+#define LEVEL2_TIME_INDEX_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <ats/types.hpp>
+
+namespace ats {
+namespace l2_time_index
+{
+	// Sidecar index of a level2 CSV day file, stored next to it as "<day file>.idx":
+	//
+	//   file_header | entry[entry_count]
+	//
+	// Entries map the time of every stride-th packet to the byte offset where the packet starts, so
+	// that readers can start replaying a day at any time without parsing what comes before it.
+	// The size of the day file is recorded to detect an index that no longer matches its day file
+
+	static const char file_magic[8] = { 'A', 'T', 'S', 'L', '2', 'I', 'D', 'X' };
+	static const uint32_t file_version = 1;
+	static const size_t stride = 64;
+
+	struct file_header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t stride;
+		uint64_t day_file_size;
+		uint64_t entry_count;
+	};
+
+	struct entry
+	{
+		int64_t time;     // nanoseconds since the Unix epoch
+		uint64_t offset;  // byte offset of the first line of the packet
+	};
+
+	static_assert(sizeof(file_header) == 32, "l2_time_index::file_header must be 32 bytes");
+	static_assert(sizeof(entry) == 16, "l2_time_index::entry must be 16 bytes");
+
+	inline std::string index_filename(const std::string& day_file)
+	{
+		return day_file + ".idx";
+	}
+
+	// Loads the index of a day file; returns false if there is none or it is out of date
+	inline bool load(const std::string& day_file, std::vector<entry>& entries)
+	{
+		boost::system::error_code ec;
+		uintmax_t size = boost::filesystem::file_size(day_file, ec);
+		if (ec)
+			return false;
+
+		std::ifstream in(index_filename(day_file), std::ios::binary);
+		file_header header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			return false;
+		if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != file_version ||
+			header.day_file_size != size)
+			return false;
+
+		entries.resize(header.entry_count);
+		if (!in.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(entry)))
+		{
+			entries.clear();
+			return false;
+		}
+		return true;
+	}
+
+	// Writes the index of a day file; returns false if it cannot be written (e.g., a read-only data directory)
+	inline bool save(const std::string& day_file, const std::vector<entry>& entries)
+	{
+		boost::system::error_code ec;
+		uintmax_t size = boost::filesystem::file_size(day_file, ec);
+		if (ec)
+			return false;
+
+		file_header header;
+		std::memcpy(header.magic, file_magic, sizeof(header.magic));
+		header.version = file_version;
+		header.stride = stride;
+		header.day_file_size = size;
+		header.entry_count = entries.size();
+
+		std::ofstream out(index_filename(day_file), std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(entry));
+		return static_cast<bool>(out);
+	}
+
+	// Byte offset to start reading from to get every packet at or after time: the offset of the last
+	// indexed packet earlier than time, so that packets of the same time preceding an entry are not missed
+	inline uint64_t find(const std::vector<entry>& entries, const ats::timestamp_t& time)
+	{
+		auto it = std::lower_bound(entries.cbegin(), entries.cend(), time.nanoseconds(),
+			[](const entry& e, int64_t t) { return e.time < t; });
+		return it == entries.cbegin() ? 0 : std::prev(it)->offset;
+	}
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,181 @@
+#ifndef MDP3_SBE_HPP
+#define MDP3_SBE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <ats/message/level2_message.hpp>
+#include <ats/types.hpp>
+
+namespace ats {
+namespace mdp3
+{
+	// Layout of CME MDP 3.0 packets (SBE schema version 9), as sent in UDP datagrams:
+	//
+	//   packet header | (message size | SBE message header | root block | groups)*
+	//
+	// All integers are little-endian. Only the fields read by the decoder are described; blocks and
+	// group entries are stepped over with the lengths they carry, so that later schema versions that
+	// append fields are read as well
+
+	static const uint16_t template_incremental_refresh_book = 46;           // MDIncrementalRefreshBook46
+	static const uint16_t template_incremental_refresh_trade_summary = 48;  // MDIncrementalRefreshTradeSummary48
+	// Trade summaries of schema version 8, retired by version 9 but still found in older captures; their
+	// entries start with the same fields
+	static const uint16_t template_incremental_refresh_trade_summary_v8 = 42;  // MDIncrementalRefreshTradeSummary42
+
+	static const size_t packet_header_size = 12;   // MsgSeqNum (uint32), SendingTime (uint64, ns since the epoch)
+	static const size_t message_header_size = 10;  // message size (uint16), then the SBE header: block
+	                                               // length, template id, schema id, version (uint16 each)
+	static const size_t group_header_size = 3;     // groupSize: block length (uint16), number of entries (uint8)
+
+	// Offsets of the fields of NoMDEntries entries of both templates
+	namespace entry
+	{
+		static const size_t price = 0;            // MDEntryPx: int64 mantissa, exponent -9
+		static const size_t size = 8;             // MDEntrySize: int32
+		static const size_t security_id = 12;     // SecurityID: int32
+		static const size_t number_of_orders = 20;  // NumberOfOrders: int32
+		static const size_t price_level = 24;     // MDPriceLevel (book): uint8
+		static const size_t aggressor_side = 24;  // AggressorSide (trade): uint8, 1 buy, 2 sell
+		static const size_t update_action = 25;   // MDUpdateAction: uint8
+		static const size_t entry_type = 26;      // MDEntryType (book): char
+		static const size_t min_book_length = 27;
+		static const size_t min_trade_length = 26;
+	}
+
+	static const int32_t int32_null = std::numeric_limits<int32_t>::max();
+	static const int64_t int64_null = std::numeric_limits<int64_t>::max();
+
+	template<typename T>
+	inline T load(const char* p)
+	{
+		T value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	// Decodes packets into the level2 messages of one security. Implied and non-book entries, and update
+	// actions other than new, change and delete are left out, like in the FIX decoders
+	class decoder
+	{
+	public:
+		// Prices are MDEntryPx mantissas divided by price_divisor (e.g., 100000000 for prices in ticks of
+		// 0.1); messages are given the symbol and exchange
+		decoder(int32_t security_id, int64_t price_divisor, const std::string& symbol, const std::string& exchange)
+			: security_id_(security_id), price_divisor_(price_divisor),
+			  symbol_(ats::symbol_registry().intern(symbol)), exchange_(ats::exchange_registry().intern(exchange)) { }
+
+		// Decodes the packet [data, data + size) into result. Returns false if the packet is malformed;
+		// the entries decoded before the error are kept
+		bool decode(const char* data, size_t size, ats::level2_message_packet& result)
+		{
+			result.messages.clear();
+			if (size < packet_header_size)
+				return false;
+
+			seq_number_ = load<uint32_t>(data);
+			result.time = ats::timestamp_t(static_cast<ats::timestamp_t::rep>(load<uint64_t>(data + 4)));
+
+			const char* end = data + size;
+			for (const char* pos = data + packet_header_size; end - pos >= 2; )
+			{
+				size_t message_size = load<uint16_t>(pos);
+				if (message_size < message_header_size || message_size > static_cast<size_t>(end - pos))
+					return false;
+
+				const char* message_end = pos + message_size;
+				uint16_t block_length = load<uint16_t>(pos + 2);
+				uint16_t template_id = load<uint16_t>(pos + 4);
+				const char* group = pos + message_header_size + block_length;
+				pos = message_end;
+
+				if (template_id != template_incremental_refresh_book && template_id != template_incremental_refresh_trade_summary &&
+					template_id != template_incremental_refresh_trade_summary_v8)
+					continue;
+				if (message_end - group < static_cast<ptrdiff_t>(group_header_size))
+					return false;
+
+				size_t entry_length = load<uint16_t>(group);
+				size_t entry_count = static_cast<uint8_t>(group[2]);
+				const char* e = group + group_header_size;
+				bool is_book = template_id == template_incremental_refresh_book;
+				if (entry_length < (is_book ? entry::min_book_length : entry::min_trade_length) ||
+					static_cast<size_t>(message_end - e) < entry_length * entry_count)
+					return false;
+
+				for (size_t i = 0; i < entry_count; ++i, e += entry_length)
+				{
+					if (load<int32_t>(e + entry::security_id) == security_id_)
+						add_entry(e, is_book, result);
+				}
+			}
+			return true;
+		}
+
+		// Sequence number of the last decoded packet
+		uint32_t seq_number() const { return seq_number_; }
+
+	private:
+		void add_entry(const char* e, bool is_book, ats::level2_message_packet& result) const
+		{
+			ats::update_action update_action;
+			switch (static_cast<uint8_t>(e[entry::update_action]))
+			{
+			case 0: update_action = ats::update_action::New; break;
+			case 1: update_action = ats::update_action::Change; break;
+			case 2: update_action = ats::update_action::Delete; break;
+			default: return;
+			}
+
+			ats::entry_type entry_type = ats::entry_type::Trade;
+			if (is_book)
+			{
+				char type = e[entry::entry_type];
+				if (type == '0')
+					entry_type = ats::entry_type::Bid;
+				else if (type == '1')
+					entry_type = ats::entry_type::Ask;
+				else
+					return;
+			}
+
+			int64_t price = load<int64_t>(e + entry::price);
+			if (price == int64_null)
+				return;
+			int32_t quantity = load<int32_t>(e + entry::size);
+			int32_t order_count = load<int32_t>(e + entry::number_of_orders);
+
+			result.messages.emplace_back();
+			ats::level2_message& m = result.messages.back();
+			m.time = result.time;
+			m.symbol_id = symbol_;
+			m.exchange_id = exchange_;
+			m.seq_number = seq_number_;
+			m.update_action = update_action;
+			m.entry_type = entry_type;
+			m.price = static_cast<ats::price_t>(price / price_divisor_);
+			m.quantity = quantity == int32_null ? 0 : quantity;
+			m.order_count = order_count == int32_null ? 0 : order_count;
+			if (is_book)
+				m.level = static_cast<uint8_t>(e[entry::price_level]);
+			else
+			{
+				m.level = 0;
+				uint8_t aggressor_side = static_cast<uint8_t>(e[entry::aggressor_side]);
+				m.aggressor_side = aggressor_side == 1 ? 1 : aggressor_side == 2 ? -1 : 0;
+			}
+		}
+
+	private:
+		int32_t security_id_;
+		int64_t price_divisor_;
+		ats::symbol_id_t symbol_;
+		ats::exchange_id_t exchange_;
+		uint32_t seq_number_ = 0;
+	};
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#ifndef PCAP_HPP
+#define PCAP_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace ats {
+namespace pcap
+{
+	// Layout of a pcap capture file (libpcap format):
+	//
+	//   file_header | (record_header | captured bytes)*
+	//
+	// The magic number tells the byte order of the writer and whether record times are in
+	// microseconds or nanoseconds
+
+	static const uint32_t magic_microseconds = 0xa1b2c3d4;
+	static const uint32_t magic_nanoseconds = 0xa1b23c4d;
+
+	static const uint32_t link_type_ethernet = 1;
+	static const uint32_t link_type_linux_sll = 113;
+
+	struct file_header
+	{
+		uint32_t magic;
+		uint16_t version_major;
+		uint16_t version_minor;
+		int32_t this_zone;
+		uint32_t sigfigs;
+		uint32_t snap_length;
+		uint32_t link_type;
+	};
+
+	struct record_header
+	{
+		uint32_t seconds;
+		uint32_t fraction;         // microseconds or nanoseconds
+		uint32_t captured_length;
+		uint32_t original_length;
+	};
+
+	static_assert(sizeof(file_header) == 24, "pcap::file_header must be 24 bytes");
+	static_assert(sizeof(record_header) == 16, "pcap::record_header must be 16 bytes");
+
+	// Reads the UDP payloads of the IPv4 packets of a capture (Ethernet, with or without VLAN tags, or
+	// Linux cooked captures); other packets, including IP fragments, are skipped. The file is
+	// memory-mapped, so that payloads are returned without copies
+	class udp_reader
+	{
+	public:
+		explicit udp_reader(const std::string& filename)
+		{
+			// Like std::ifstream, a missing or empty file is simply a file without packets
+			boost::system::error_code ec;
+			uintmax_t size = boost::filesystem::file_size(filename, ec);
+			if (ec || size == 0)
+				return;
+
+			file_.open(filename);
+			pos_ = file_.data();
+			end_ = pos_ + file_.size();
+
+			file_header header;
+			if (end_ - pos_ < static_cast<ptrdiff_t>(sizeof(header)))
+				throw std::runtime_error("pcap::udp_reader: '" + filename + "' is not a pcap file");
+			std::memcpy(&header, pos_, sizeof(header));
+			pos_ += sizeof(header);
+
+			if (header.magic == magic_microseconds || header.magic == magic_nanoseconds)
+				swapped_ = false;
+			else if (swap(header.magic) == magic_microseconds || swap(header.magic) == magic_nanoseconds)
+				swapped_ = true;
+			else
+				throw std::runtime_error("pcap::udp_reader: '" + filename + "' is not a pcap file");
+
+			link_type_ = get(header.link_type);
+			if (link_type_ != link_type_ethernet && link_type_ != link_type_linux_sll)
+				throw std::runtime_error("pcap::udp_reader: Unsupported link type of '" + filename + "'");
+		}
+
+		// Returns the payload of the next UDP datagram and its destination port; false at the end of the
+		// capture
+		bool next(const char*& payload, size_t& size, uint16_t& port)
+		{
+			while (end_ - pos_ >= static_cast<ptrdiff_t>(sizeof(record_header)))
+			{
+				record_header header;
+				std::memcpy(&header, pos_, sizeof(header));
+				const char* frame = pos_ + sizeof(header);
+				size_t length = get(header.captured_length);
+				if (static_cast<size_t>(end_ - frame) < length)
+					break;  // truncated capture
+				pos_ = frame + length;
+
+				if (parse_frame(frame, length, payload, size, port))
+					return true;
+			}
+			pos_ = end_;
+			return false;
+		}
+
+	private:
+		bool parse_frame(const char* frame, size_t length, const char*& payload, size_t& size, uint16_t& port) const
+		{
+			size_t offset;
+			uint16_t ether_type;
+			if (link_type_ == link_type_ethernet)
+			{
+				offset = 14;
+				if (length < offset) return false;
+				ether_type = be16(frame + 12);
+				while ((ether_type == 0x8100 || ether_type == 0x88a8) && length >= offset + 4)
+				{
+					ether_type = be16(frame + offset + 2);
+					offset += 4;
+				}
+			}
+			else
+			{
+				offset = 16;
+				if (length < offset) return false;
+				ether_type = be16(frame + 14);
+			}
+			if (ether_type != 0x0800)
+				return false;
+
+			// IPv4
+			const char* ip = frame + offset;
+			if (length < offset + 20 || (ip[0] >> 4) != 4)
+				return false;
+			size_t ip_header_length = (ip[0] & 0x0f) * 4;
+			size_t ip_length = be16(ip + 2);
+			bool is_fragment = (be16(ip + 6) & 0x3fff) != 0;
+			if (static_cast<uint8_t>(ip[9]) != 17 || is_fragment || ip_header_length < 20 ||
+				ip_length < ip_header_length + 8 || length < offset + ip_length)
+				return false;
+
+			// UDP
+			const char* udp = ip + ip_header_length;
+			size_t udp_length = be16(udp + 4);
+			if (udp_length < 8 || udp_length > ip_length - ip_header_length)
+				return false;
+
+			port = be16(udp + 2);
+			payload = udp + 8;
+			size = udp_length - 8;
+			return true;
+		}
+
+		uint32_t get(uint32_t value) const { return swapped_ ? swap(value) : value; }
+
+		static uint32_t swap(uint32_t value)
+		{
+			return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+		}
+
+		static uint16_t be16(const char* p)
+		{
+			return static_cast<uint16_t>((static_cast<uint8_t>(p[0]) << 8) | static_cast<uint8_t>(p[1]));
+		}
+
+	private:
+		boost::iostreams::mapped_file_source file_;  // memory-mapped capture
+		const char* pos_ = nullptr;                  // next record
+		const char* end_ = nullptr;
+		bool swapped_ = false;                       // the file was written in the other byte order
+		uint32_t link_type_ = link_type_ethernet;
+	};
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,292 @@
+#ifndef FIX_MD_INCREMENTAL_REFRESH_HPP
+#define FIX_MD_INCREMENTAL_REFRESH_HPP
+
+// Generated from FIX50SP2_CME.xml by ats::fix_decoder_generator::generate (see fix_decoder_generator.hpp).
+// Do not edit: regenerate instead
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <charconv>
+#include <ats/message/level2_message.hpp>
+#include <ats/types.hpp>
+
+namespace ats {
+namespace fix_md
+{
+	// Decoder of MarketDataIncrementalRefresh (35=X) messages into level2 packets, equivalent to
+	// ats::parse_fix_msg without a FIX::Message: fields are scanned once and converted in place, so that
+	// decoding performs no heap allocations once the packet has grown to the size of a message
+	class incremental_refresh_decoder
+	{
+	public:
+		// Entries of other symbols (SecurityDesc) than the given ones (any if there is none) are left
+		// out. Messages are given the exchange, or their SenderCompID if it is empty
+		explicit incremental_refresh_decoder(const std::vector<std::string>& symbols = {}, const std::string& exchange = "")
+			: symbols_(symbols),
+			  exchange_id_(exchange.empty() ? ats::name_registry::npos : ats::exchange_registry().intern(exchange)) { }
+
+		// Decodes the message [begin, end) of tag=value fields ended by delimiter. Exchange best quotes
+		// and entries other than bids, offers and trades are left out. Returns false if the message is
+		// not a MarketDataIncrementalRefresh or misses a header field
+		bool decode(const char* begin, const char* end, ats::level2_message_packet& result, char delimiter = '\x01')
+		{
+			result.messages.clear();
+
+			std::string_view exchange;
+			bool has_time = false, has_seq_number = false, has_count = false;
+			long seq_number = 0, count = 0, entries = 0;
+			entry e;
+
+			for (const char* pos = begin; pos < end; )
+			{
+				const char* eq = static_cast<const char*>(std::memchr(pos, '=', end - pos));
+				if (eq == nullptr) break;
+				const char* eof = static_cast<const char*>(std::memchr(eq, delimiter, end - eq));
+				if (eof == nullptr) eof = end;
+
+				int tag = 0;
+				bool is_tag = std::from_chars(pos, eq, tag).ptr == eq;
+				std::string_view value(eq + 1, eof - eq - 1);
+				pos = eof + 1;
+				if (!is_tag) continue;
+
+				switch (tag)
+				{
+				case 35:
+					if (value != "X") return false;
+					break;
+				case 34:
+					has_seq_number = to_long(value, seq_number);
+					break;
+				case 52:
+					has_time = parse_time(value, result.time);
+					break;
+				case 49:
+					exchange = value;
+					break;
+				case 268:
+					has_count = to_long(value, count);
+					break;
+				case 279:  // delimiter of entries
+					if (entries > 0)
+						add_entry(e, result);
+					if (++entries > count)
+						e.is_valid = false;
+					else
+						e = entry(value);
+					break;
+				case 107:
+					e.symbol = value;
+					e.has_symbol = true;
+					break;
+				case 276:
+					if (value.size() == 1 && value[0] == 'C') e.is_valid = false;
+					break;
+				case 269:
+					e.entry_type = value.size() == 1 ? value[0] : '\0';
+					break;
+				case 270:
+					e.has_price = to_long(value, e.price);
+					break;
+				case 271:
+					e.has_quantity = to_long(value, e.quantity);
+					break;
+				case 1023:
+					e.has_level = to_long(value, e.level);
+					break;
+				case 346:
+					e.has_order_count = to_long(value, e.order_count);
+					break;
+				case 5797:
+					e.has_aggressor_side = to_long(value, e.aggressor_side);
+					break;
+				default:
+					break;
+				}
+			}
+			if (entries > 0)
+				add_entry(e, result);
+
+			if (!has_count || !has_time || !has_seq_number || exchange.empty())
+			{
+				result.messages.clear();
+				return false;
+			}
+
+			if (exchange_id_ != ats::name_registry::npos)
+				result.exchange_id = exchange_id_;
+			else
+			{
+				// Senders rarely change within a log, so that they are only interned when they do
+				if (exchange != sender_)
+				{
+					sender_.assign(exchange.data(), exchange.size());
+					sender_id_ = ats::exchange_registry().intern(sender_);
+				}
+				result.exchange_id = sender_id_;
+			}
+			for (auto& m : result.messages)
+			{
+				m.time = result.time;
+				m.seq_number = seq_number;
+				m.exchange_id = result.exchange_id;
+			}
+			return true;
+		}
+
+	private:
+		// Fields of the current group entry
+		struct entry
+		{
+			entry() = default;
+			explicit entry(std::string_view update_action)
+				: update_action(update_action.size() == 1 ? update_action[0] : '\0'), is_valid(true) { }
+
+			std::string_view symbol;
+			char update_action = '\0';
+			char entry_type = '\0';
+			long price = 0;
+			long quantity = 0;
+			long level = 0;
+			long order_count = 0;
+			long aggressor_side = 0;
+			bool is_valid = false;
+			bool has_symbol = false;
+			bool has_price = false;
+			bool has_quantity = false;
+			bool has_level = false;
+			bool has_order_count = false;
+			bool has_aggressor_side = false;
+		};
+
+		void add_entry(const entry& e, ats::level2_message_packet& result)
+		{
+			if (!e.is_valid || !e.has_symbol || !e.has_price || !e.has_quantity)
+				return;
+			ats::symbol_id_t symbol_id = find_symbol(e.symbol);
+			if (symbol_id == ats::name_registry::npos)
+				return;
+
+			ats::update_action update_action;
+			switch (e.update_action)
+			{
+			case '0': update_action = ats::update_action::New; break;
+			case '1': update_action = ats::update_action::Change; break;
+			case '2': update_action = ats::update_action::Delete; break;
+			default: return;
+			}
+
+			ats::entry_type entry_type;
+			switch (e.entry_type)
+			{
+			case '0': entry_type = ats::entry_type::Bid; break;
+			case '1': entry_type = ats::entry_type::Ask; break;
+			case '2': entry_type = ats::entry_type::Trade; break;
+			default: return;
+			}
+
+			// Book entries need their level and number of orders
+			if (entry_type != ats::entry_type::Trade && (!e.has_level || !e.has_order_count))
+				return;
+
+			result.messages.emplace_back();
+			ats::level2_message& m = result.messages.back();
+			m.symbol_id = symbol_id;
+			m.update_action = update_action;
+			m.entry_type = entry_type;
+			m.price = e.price;
+			m.quantity = e.quantity;
+			if (entry_type == ats::entry_type::Trade)
+			{
+				m.level = 0;
+				if (e.has_aggressor_side)
+					m.aggressor_side = e.aggressor_side == 2 ? -1 : e.aggressor_side;
+			}
+			else
+			{
+				m.level = e.level;
+				m.order_count = e.order_count;
+			}
+		}
+
+		// Interned id of a symbol, npos if the symbol is not wanted. Symbols are looked up in the registry
+		// once per decoder; the keys of the cache are views of the names held by the registry
+		ats::symbol_id_t find_symbol(std::string_view symbol)
+		{
+			auto it = symbol_ids_.find(symbol);
+			if (it != symbol_ids_.cend())
+				return it->second;
+
+			std::string name(symbol);
+			bool is_wanted = symbols_.empty() || std::find(symbols_.cbegin(), symbols_.cend(), name) != symbols_.cend();
+			ats::symbol_id_t id = is_wanted ? ats::symbol_registry().intern(name) : ats::name_registry::npos;
+			std::string_view key = is_wanted ? std::string_view(ats::symbol_registry().name(id)) : std::string_view(*unwanted_.insert(name).first);
+			symbol_ids_.insert(std::make_pair(key, id));
+			return id;
+		}
+
+		// Integer part of a number, like std::stoi
+		static bool to_long(std::string_view value, long& result)
+		{
+			const char* first = value.data();
+			const char* last = first + value.size();
+			if (first != last && *first == '+') ++first;
+			return std::from_chars(first, last, result).ptr != first;
+		}
+
+		// SendingTime as YYYYMMDD-HH:MM:SS.sss or YYYYMMDDHHMMSSsss (any number of fractional digits);
+		// the start of the day of the last date is cached
+		bool parse_time(std::string_view value, ats::timestamp_t& result)
+		{
+			char digits[32];
+			size_t n = 0;
+			for (char c : value)
+			{
+				if (c >= '0' && c <= '9' && n < sizeof(digits))
+					digits[n++] = c;
+			}
+			if (n < 14) return false;
+
+			if (std::memcmp(digits, date_str_, sizeof(date_str_)) != 0)
+			{
+				auto number = [&](size_t i, size_t count) { int x = 0; while (count--) x = x * 10 + digits[i++] - '0'; return x; };
+				try
+				{
+					boost::gregorian::date date(number(0, 4), number(4, 2), number(6, 2));
+					date_ = ats::timestamp_t(ats::date_time::date_time(date));
+				}
+				catch (...)
+				{
+					return false;
+				}
+				std::memcpy(date_str_, digits, sizeof(date_str_));
+			}
+
+			auto number = [&](size_t i, size_t count) { long long x = 0; while (count--) x = x * 10 + digits[i++] - '0'; return x; };
+			long long ns = ((number(8, 2) * 60 + number(10, 2)) * 60 + number(12, 2)) * 1000000000LL;
+			long long scale = 100000000LL;
+			for (size_t i = 14; i < n && scale > 0; ++i, scale /= 10)
+				ns += (digits[i] - '0') * scale;
+			result = date_ + ats::timestamp_t::duration(ns);
+			return true;
+		}
+
+	private:
+		std::vector<std::string> symbols_;
+		ats::exchange_id_t exchange_id_;                                   // npos to use SenderCompID
+		std::string sender_;                                               // SenderCompID of the last message
+		ats::exchange_id_t sender_id_ = ats::name_registry::npos;
+		std::unordered_map<std::string_view, ats::symbol_id_t> symbol_ids_;  // npos for unwanted symbols
+		std::set<std::string> unwanted_;                                   // names of unwanted symbols seen
+		char date_str_[8] = { };  // cached YYYYMMDD
+		ats::timestamp_t date_;   // midnight of that date
+	};
+}
+}
+
+#endif
\ No newline at end of file
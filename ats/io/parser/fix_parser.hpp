@@ -32,10 +32,11 @@ namespace ats
 			FIX::Header header = msg.getHeader();
 			value = header.getField(52);
 			long millis = std::strtol(&value[value.size() - 3], nullptr, 10);
-			result.time.parse(value, "%Y%m%d%H%M%S");
-			result.time += boost::posix_time::milliseconds(millis);
+			ats::date_time::date_time sending_time(value, "%Y%m%d%H%M%S");
+			sending_time += boost::posix_time::milliseconds(millis);
+			result.time = ats::timestamp_t(sending_time);
 			seq_number = std::strtol(&header.getField(34)[0], nullptr, 10);
-			result.exchange = header.getField(49);
+			result.exchange_id = ats::exchange_registry().intern(header.getField(49));
 		}
 		catch (...)
 		{
@@ -77,8 +78,8 @@ namespace ats
 					e.symbol = group.getField(symbolField).getString();;
 				}
 				catch(...) { }*/
-				m.symbol = value;
-				m.exchange = result.exchange;
+				m.symbol_id = ats::symbol_registry().intern(value);
+				m.exchange_id = result.exchange_id;
 
 				// MDUpdateAction
 				value = group.getField(279);
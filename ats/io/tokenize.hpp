@@ -2,6 +2,7 @@
 #define TOKENIZE_HPP
 
 #include <string>
+#include <string_view>
 #include <array>
 
 namespace ats
@@ -29,6 +30,30 @@ namespace ats
 
 		return i;
 	}
+
+	// Same as above, but the fields are views into the line (nothing is copied)
+	template<size_t num_cols>
+	static size_t tokenize(std::string_view line, std::array<std::string_view, num_cols>& result, char sep = ',')
+	{
+		size_t i = 0U;
+		size_t begin = 0U;
+		for (size_t pos = 0U; pos < line.size() && i < num_cols; ++pos)
+		{
+			if (line[pos] == sep)
+			{
+				result[i++] = line.substr(begin, pos - begin);
+				begin = pos + 1;
+			}
+		}
+
+		if (i == num_cols)
+			return num_cols + 1;
+
+		if (i < num_cols)
+			result[i++] = line.substr(begin);
+
+		return i;
+	}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,251 @@
+#ifndef SPREAD_SYNTHESIZER_HPP
+#define SPREAD_SYNTHESIZER_HPP
+
+#include <array>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <charconv>
+#include <stdexcept>
+#include <ats/io/tokenize.hpp>
+#include <ats/date_time/timestamp.hpp>
+#include <ats/types.hpp>
+
+namespace ats
+{
+	// Leg of a synthetic spread. A leg contributes ratio * (price * multiplier / divisor) to the spread:
+	// the ratio is the signed number of contracts (e.g., 3, -2, -1 for a 3:2:1 crack spread), while the
+	// multiplier and divisor bring the prices of the legs to common units. Buying legs (positive ratio)
+	// are bought at their ask and sold at their bid; selling legs the other way round
+	struct spread_leg
+	{
+		std::string filename;  // BBO file of the leg (see spread_synthesizer)
+		long ratio = 1;
+		long multiplier = 1;
+		long divisor = 1;
+	};
+
+	// Synthetic top of book at a merge step
+	struct spread_quote
+	{
+		long seq_num = 0;   // the greatest sequence number of the current quotes of the legs
+		ats::timestamp_t time;
+		long bid = 0;
+		long ask = 0;
+	};
+
+namespace spread_detail
+{
+	// Reads a BBO file "Symbol;Exchange;SeqNum;Timestamp;BidPrc;AskPrc" (after a header line) one quote
+	// at a time, keeping the next quote as a look-ahead
+	class bbo_reader
+	{
+	public:
+		struct bbo
+		{
+			long seq_num = 0;
+			ats::timestamp_t time;
+			long bid = 0, ask = 0;
+		};
+
+		explicit bbo_reader(const std::string& filename)
+			: stream_(filename)
+		{
+			if (!stream_)
+				throw std::invalid_argument("spread_synthesizer: Cannot open '" + filename + "'");
+
+			std::getline(stream_, line_);  // header
+			has_current_ = read(current_);
+			has_next_ = has_current_ && read(next_);
+		}
+
+		const bbo& current() const { return current_; }
+		const bbo& next() const { return next_; }
+		bool has_current() const { return has_current_; }
+		bool has_next() const { return has_next_; }
+		const std::string& symbol() const { return symbol_; }
+
+		void advance()
+		{
+			current_ = next_;
+			has_next_ = read(next_);
+		}
+
+	private:
+		// Reads the next quote; false at the end of the file or at the first malformed line
+		bool read(bbo& quote)
+		{
+			while (std::getline(stream_, line_))
+			{
+				std::string_view line(line_);
+				if (!line.empty() && line.back() == '\r')
+					line.remove_suffix(1);
+				if (line.empty())
+					continue;
+
+				if (ats::tokenize(line, fields_, ';') != fields_.size() ||
+					!parse(fields_[2], quote.seq_num) || !parse(fields_[4], quote.bid) || !parse(fields_[5], quote.ask))
+					return false;
+				time_parser_.parse(fields_[3].data(), fields_[3].size(), quote.time);
+
+				if (symbol_.empty())
+					symbol_.assign(fields_[0]);
+				return true;
+			}
+			return false;
+		}
+
+		static bool parse(std::string_view field, long& value)
+		{
+			while (!field.empty() && field.front() == ' ')
+				field.remove_prefix(1);
+			return std::from_chars(field.data(), field.data() + field.size(), value).ec == std::errc();
+		}
+
+	private:
+		std::ifstream stream_;
+		std::string line_;
+		std::array<std::string_view, 6U> fields_;
+		ats::date_time::timestamp_parser time_parser_;
+		std::string symbol_;  // symbol of the first quote
+		bbo current_, next_;
+		bool has_current_ = false;
+		bool has_next_ = false;
+	};
+}
+
+	// Merges the BBO files of the legs of a spread by sequence number and computes the synthetic quotes
+	// one merge step at a time, so that only the current and the next quote of every leg are held in
+	// memory. The series starts at the first quote of the leg that starts last (the other legs at their
+	// last quotes before it); each step then advances the legs with the smallest next sequence number
+	// and takes the time of the first of them. The series ends before the last quote of the leg that
+	// ends first
+	class spread_synthesizer
+	{
+	public:
+		explicit spread_synthesizer(const std::vector<ats::spread_leg>& legs)
+			: legs_(legs)
+		{
+			if (legs_.empty())
+				throw std::invalid_argument("spread_synthesizer: A spread needs at least one leg");
+
+			readers_.reserve(legs_.size());
+			for (const auto& leg : legs_)
+			{
+				if (leg.divisor == 0)
+					throw std::invalid_argument("spread_synthesizer: Divisor of '" + leg.filename + "' is zero");
+				readers_.emplace_back(leg.filename);
+			}
+
+			for (const auto& reader : readers_)
+			{
+				if (!symbol_.empty())
+					symbol_ += '-';
+				symbol_ += reader.symbol();
+			}
+
+			start();
+		}
+
+		// Symbol of the spread, the symbols of the legs joined by '-'
+		const std::string& symbol() const { return symbol_; }
+
+		// Computes the next quote of the series; false at its end
+		bool next(ats::spread_quote& quote)
+		{
+			for (const auto& reader : readers_)
+			{
+				if (!reader.has_next())
+					return false;
+			}
+
+			quote.seq_num = 0;
+			quote.time = time_;
+			quote.bid = quote.ask = 0;
+			for (size_t k = 0; k < readers_.size(); ++k)
+			{
+				const auto& leg = legs_[k];
+				const auto& bbo = readers_[k].current();
+				long bid = bbo.bid * leg.multiplier / leg.divisor;
+				long ask = bbo.ask * leg.multiplier / leg.divisor;
+				quote.bid += leg.ratio * (leg.ratio > 0 ? bid : ask);
+				quote.ask += leg.ratio * (leg.ratio > 0 ? ask : bid);
+				quote.seq_num = std::max(quote.seq_num, bbo.seq_num);
+			}
+
+			long seq_num = readers_.front().next().seq_num;
+			for (const auto& reader : readers_)
+				seq_num = std::min(seq_num, reader.next().seq_num);
+
+			bool is_first = true;
+			for (auto& reader : readers_)
+			{
+				if (reader.next().seq_num != seq_num)
+					continue;
+				if (is_first)
+					time_ = reader.next().time;
+				is_first = false;
+				reader.advance();
+			}
+			return true;
+		}
+
+	private:
+		// Aligns the legs at the first quote of the leg that starts last
+		void start()
+		{
+			const spread_detail::bbo_reader* last = nullptr;
+			for (const auto& reader : readers_)
+			{
+				if (!reader.has_current())
+					return;
+				if (last == nullptr || reader.current().seq_num > last->current().seq_num)
+					last = &reader;
+			}
+
+			long seq_num = last->current().seq_num;
+			time_ = last->current().time;
+			for (auto& reader : readers_)
+			{
+				while (reader.has_next() && reader.next().seq_num < seq_num)
+					reader.advance();
+			}
+		}
+
+	private:
+		std::vector<ats::spread_leg> legs_;
+		std::vector<spread_detail::bbo_reader> readers_;
+		std::string symbol_;
+		ats::timestamp_t time_;  // time of the next quote
+	};
+
+	// Writes the synthetic quotes of a spread (see spread_synthesizer) into out_file, one line
+	// "Symbol; Timestamp; BidPrc; AskPrc" per quote, with times in milliseconds
+	static void synthesize_spread(const std::vector<ats::spread_leg>& legs, const std::string& out_file,
+			const std::string& header = "Symbol; Timestamp; BidPrc; AskPrc")
+	{
+		ats::spread_synthesizer spread(legs);
+
+		std::ofstream out(out_file);
+		if (!out)
+			throw std::invalid_argument("synthesize_spread: Cannot open '" + out_file + "'");
+		out << header << '\n';
+
+		ats::spread_quote quote;
+		std::string tm_str;
+		while (spread.next(quote))
+		{
+			tm_str = quote.time.to_string("%Y%m%d %H%M%S.%f");
+			tm_str.resize(tm_str.size() - 3);
+			out << spread.symbol() << "; " << tm_str << "; " << quote.bid << "; " << quote.ask << '\n';
+		}
+
+		out.close();
+		if (!out)
+			throw std::runtime_error("synthesize_spread: Cannot write '" + out_file + "'");
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,477 @@
+#ifndef FIX_DECODER_GENERATOR_HPP
+#define FIX_DECODER_GENERATOR_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <fstream>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+namespace ats {
+namespace fix_decoder_generator
+{
+	using ptree = boost::property_tree::ptree;
+
+	struct field_def
+	{
+		int number = 0;
+		std::map<std::string, std::string> values;  // enum values by description
+	};
+
+	// Definitions of a QuickFIX data dictionary needed to generate a decoder
+	class dictionary
+	{
+	public:
+		explicit dictionary(const std::string& fix_specs_xml)
+		{
+			boost::property_tree::read_xml(fix_specs_xml, xml_);
+
+			for (const auto& node : xml_.get_child("fix.fields"))
+			{
+				if (node.first != "field") continue;
+				field_def field;
+				field.number = node.second.get<int>("<xmlattr>.number");
+				for (const auto& value : node.second)
+				{
+					if (value.first == "value")
+						field.values[value.second.get<std::string>("<xmlattr>.description")] = value.second.get<std::string>("<xmlattr>.enum");
+				}
+				fields_[node.second.get<std::string>("<xmlattr>.name")] = field;
+			}
+
+			for (const auto& node : xml_.get_child("fix.components"))
+			{
+				if (node.first == "component")
+					components_[node.second.get<std::string>("<xmlattr>.name")] = &node.second;
+			}
+		}
+
+		int tag(const std::string& field) const { return get(field).number; }
+
+		// Enum value of a field; CHAR fields (and single-character values of string fields) are decoded
+		// as characters
+		char value(const std::string& field, const std::string& description) const
+		{
+			const field_def& def = get(field);
+			auto it = def.values.find(description);
+			if (it == def.values.cend() || it->second.size() != 1)
+				throw std::runtime_error("fix_decoder_generator: No single-character value " + description + " of field " + field);
+			return it->second[0];
+		}
+
+		const ptree& message(const std::string& name) const
+		{
+			for (const auto& node : xml_.get_child("fix.messages"))
+			{
+				if (node.first == "message" && node.second.get<std::string>("<xmlattr>.name") == name)
+					return node.second;
+			}
+			throw std::runtime_error("fix_decoder_generator: No message " + name);
+		}
+
+		// Repeating group called name in a message or component, looked up through its components
+		const ptree* find_group(const ptree& parent, const std::string& name) const
+		{
+			for (const auto& node : parent)
+			{
+				if (node.first == "group" && node.second.get<std::string>("<xmlattr>.name") == name)
+					return &node.second;
+				if (node.first == "component")
+				{
+					const ptree* group = find_group(component(node.second), name);
+					if (group != nullptr)
+						return group;
+				}
+			}
+			return nullptr;
+		}
+
+		// Fields of a group entry (not of its nested groups); the first one is the delimiter of entries
+		void group_fields(const ptree& group, std::vector<std::string>& fields) const
+		{
+			for (const auto& node : group)
+			{
+				if (node.first == "field")
+					fields.push_back(node.second.get<std::string>("<xmlattr>.name"));
+				else if (node.first == "component")
+					group_fields(component(node.second), fields);
+			}
+		}
+
+	private:
+		const field_def& get(const std::string& field) const
+		{
+			auto it = fields_.find(field);
+			if (it == fields_.cend())
+				throw std::runtime_error("fix_decoder_generator: No field " + field);
+			return it->second;
+		}
+
+		const ptree& component(const ptree& node) const
+		{
+			std::string name = node.get<std::string>("<xmlattr>.name");
+			auto it = components_.find(name);
+			if (it == components_.cend())
+				throw std::runtime_error("fix_decoder_generator: No component " + name);
+			return *it->second;
+		}
+
+	private:
+		ptree xml_;
+		std::map<std::string, field_def> fields_;
+		std::map<std::string, const ptree*> components_;
+	};
+
+	inline void replace_all(std::string& text, const std::string& from, const std::string& to)
+	{
+		for (size_t pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size()))
+			text.replace(pos, from.size(), to);
+	}
+
+	// Code of the decoder, in which @Name@ stands for the tag of field Name and @Name.DESCRIPTION@ for
+	// one of its values
+	static const char* decoder_template = R"(#ifndef FIX_MD_INCREMENTAL_REFRESH_HPP
+#define FIX_MD_INCREMENTAL_REFRESH_HPP
+
+// Generated from @Dictionary@ by ats::fix_decoder_generator::generate (see fix_decoder_generator.hpp).
+// Do not edit: regenerate instead
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <charconv>
+#include <ats/message/level2_message.hpp>
+#include <ats/types.hpp>
+
+namespace ats {
+namespace fix_md
+{
+	// Decoder of MarketDataIncrementalRefresh (35=@MsgType.MarketDataIncrementalRefresh@) messages into level2 packets, equivalent to
+	// ats::parse_fix_msg without a FIX::Message: fields are scanned once and converted in place, so that
+	// decoding performs no heap allocations once the packet has grown to the size of a message
+	class incremental_refresh_decoder
+	{
+	public:
+		// Entries of other symbols (SecurityDesc) than the given ones (any if there is none) are left
+		// out. Messages are given the exchange, or their SenderCompID if it is empty
+		explicit incremental_refresh_decoder(const std::vector<std::string>& symbols = {}, const std::string& exchange = "")
+			: symbols_(symbols),
+			  exchange_id_(exchange.empty() ? ats::name_registry::npos : ats::exchange_registry().intern(exchange)) { }
+
+		// Decodes the message [begin, end) of tag=value fields ended by delimiter. Exchange best quotes
+		// and entries other than bids, offers and trades are left out. Returns false if the message is
+		// not a MarketDataIncrementalRefresh or misses a header field
+		bool decode(const char* begin, const char* end, ats::level2_message_packet& result, char delimiter = '\x01')
+		{
+			result.messages.clear();
+
+			std::string_view exchange;
+			bool has_time = false, has_seq_number = false, has_count = false;
+			long seq_number = 0, count = 0, entries = 0;
+			entry e;
+
+			for (const char* pos = begin; pos < end; )
+			{
+				const char* eq = static_cast<const char*>(std::memchr(pos, '=', end - pos));
+				if (eq == nullptr) break;
+				const char* eof = static_cast<const char*>(std::memchr(eq, delimiter, end - eq));
+				if (eof == nullptr) eof = end;
+
+				int tag = 0;
+				bool is_tag = std::from_chars(pos, eq, tag).ptr == eq;
+				std::string_view value(eq + 1, eof - eq - 1);
+				pos = eof + 1;
+				if (!is_tag) continue;
+
+				switch (tag)
+				{
+				case @MsgType@:
+					if (value != "@MsgType.MarketDataIncrementalRefresh@") return false;
+					break;
+				case @MsgSeqNum@:
+					has_seq_number = to_long(value, seq_number);
+					break;
+				case @SendingTime@:
+					has_time = parse_time(value, result.time);
+					break;
+				case @SenderCompID@:
+					exchange = value;
+					break;
+				case @NoMDEntries@:
+					has_count = to_long(value, count);
+					break;
+				case @MDUpdateAction@:  // delimiter of entries
+					if (entries > 0)
+						add_entry(e, result);
+					if (++entries > count)
+						e.is_valid = false;
+					else
+						e = entry(value);
+					break;
+				case @SecurityDesc@:
+					e.symbol = value;
+					e.has_symbol = true;
+					break;
+				case @QuoteCondition@:
+					if (value.size() == 1 && value[0] == '@QuoteCondition.EXCHANGE_BEST@') e.is_valid = false;
+					break;
+				case @MDEntryType@:
+					e.entry_type = value.size() == 1 ? value[0] : '\0';
+					break;
+				case @MDEntryPx@:
+					e.has_price = to_long(value, e.price);
+					break;
+				case @MDEntrySize@:
+					e.has_quantity = to_long(value, e.quantity);
+					break;
+				case @MDPriceLevel@:
+					e.has_level = to_long(value, e.level);
+					break;
+				case @NumberOfOrders@:
+					e.has_order_count = to_long(value, e.order_count);
+					break;
+				case @AggressorSide@:
+					e.has_aggressor_side = to_long(value, e.aggressor_side);
+					break;
+				default:
+					break;
+				}
+			}
+			if (entries > 0)
+				add_entry(e, result);
+
+			if (!has_count || !has_time || !has_seq_number || exchange.empty())
+			{
+				result.messages.clear();
+				return false;
+			}
+
+			if (exchange_id_ != ats::name_registry::npos)
+				result.exchange_id = exchange_id_;
+			else
+			{
+				// Senders rarely change within a log, so that they are only interned when they do
+				if (exchange != sender_)
+				{
+					sender_.assign(exchange.data(), exchange.size());
+					sender_id_ = ats::exchange_registry().intern(sender_);
+				}
+				result.exchange_id = sender_id_;
+			}
+			for (auto& m : result.messages)
+			{
+				m.time = result.time;
+				m.seq_number = seq_number;
+				m.exchange_id = result.exchange_id;
+			}
+			return true;
+		}
+
+	private:
+		// Fields of the current group entry
+		struct entry
+		{
+			entry() = default;
+			explicit entry(std::string_view update_action)
+				: update_action(update_action.size() == 1 ? update_action[0] : '\0'), is_valid(true) { }
+
+			std::string_view symbol;
+			char update_action = '\0';
+			char entry_type = '\0';
+			long price = 0;
+			long quantity = 0;
+			long level = 0;
+			long order_count = 0;
+			long aggressor_side = 0;
+			bool is_valid = false;
+			bool has_symbol = false;
+			bool has_price = false;
+			bool has_quantity = false;
+			bool has_level = false;
+			bool has_order_count = false;
+			bool has_aggressor_side = false;
+		};
+
+		void add_entry(const entry& e, ats::level2_message_packet& result)
+		{
+			if (!e.is_valid || !e.has_symbol || !e.has_price || !e.has_quantity)
+				return;
+			ats::symbol_id_t symbol_id = find_symbol(e.symbol);
+			if (symbol_id == ats::name_registry::npos)
+				return;
+
+			ats::update_action update_action;
+			switch (e.update_action)
+			{
+			case '@MDUpdateAction.NEW@': update_action = ats::update_action::New; break;
+			case '@MDUpdateAction.CHANGE@': update_action = ats::update_action::Change; break;
+			case '@MDUpdateAction.DELETE@': update_action = ats::update_action::Delete; break;
+			default: return;
+			}
+
+			ats::entry_type entry_type;
+			switch (e.entry_type)
+			{
+			case '@MDEntryType.BID@': entry_type = ats::entry_type::Bid; break;
+			case '@MDEntryType.OFFER@': entry_type = ats::entry_type::Ask; break;
+			case '@MDEntryType.TRADE@': entry_type = ats::entry_type::Trade; break;
+			default: return;
+			}
+
+			// Book entries need their level and number of orders
+			if (entry_type != ats::entry_type::Trade && (!e.has_level || !e.has_order_count))
+				return;
+
+			result.messages.emplace_back();
+			ats::level2_message& m = result.messages.back();
+			m.symbol_id = symbol_id;
+			m.update_action = update_action;
+			m.entry_type = entry_type;
+			m.price = e.price;
+			m.quantity = e.quantity;
+			if (entry_type == ats::entry_type::Trade)
+			{
+				m.level = 0;
+				if (e.has_aggressor_side)
+					m.aggressor_side = e.aggressor_side == @AggressorSide.SELL@ ? -1 : e.aggressor_side;
+			}
+			else
+			{
+				m.level = e.level;
+				m.order_count = e.order_count;
+			}
+		}
+
+		// Interned id of a symbol, npos if the symbol is not wanted. Symbols are looked up in the registry
+		// once per decoder; the keys of the cache are views of the names held by the registry
+		ats::symbol_id_t find_symbol(std::string_view symbol)
+		{
+			auto it = symbol_ids_.find(symbol);
+			if (it != symbol_ids_.cend())
+				return it->second;
+
+			std::string name(symbol);
+			bool is_wanted = symbols_.empty() || std::find(symbols_.cbegin(), symbols_.cend(), name) != symbols_.cend();
+			ats::symbol_id_t id = is_wanted ? ats::symbol_registry().intern(name) : ats::name_registry::npos;
+			std::string_view key = is_wanted ? std::string_view(ats::symbol_registry().name(id)) : std::string_view(*unwanted_.insert(name).first);
+			symbol_ids_.insert(std::make_pair(key, id));
+			return id;
+		}
+
+		// Integer part of a number, like std::stoi
+		static bool to_long(std::string_view value, long& result)
+		{
+			const char* first = value.data();
+			const char* last = first + value.size();
+			if (first != last && *first == '+') ++first;
+			return std::from_chars(first, last, result).ptr != first;
+		}
+
+		// SendingTime as YYYYMMDD-HH:MM:SS.sss or YYYYMMDDHHMMSSsss (any number of fractional digits);
+		// the start of the day of the last date is cached
+		bool parse_time(std::string_view value, ats::timestamp_t& result)
+		{
+			char digits[32];
+			size_t n = 0;
+			for (char c : value)
+			{
+				if (c >= '0' && c <= '9' && n < sizeof(digits))
+					digits[n++] = c;
+			}
+			if (n < 14) return false;
+
+			if (std::memcmp(digits, date_str_, sizeof(date_str_)) != 0)
+			{
+				auto number = [&](size_t i, size_t count) { int x = 0; while (count--) x = x * 10 + digits[i++] - '0'; return x; };
+				try
+				{
+					boost::gregorian::date date(number(0, 4), number(4, 2), number(6, 2));
+					date_ = ats::timestamp_t(ats::date_time::date_time(date));
+				}
+				catch (...)
+				{
+					return false;
+				}
+				std::memcpy(date_str_, digits, sizeof(date_str_));
+			}
+
+			auto number = [&](size_t i, size_t count) { long long x = 0; while (count--) x = x * 10 + digits[i++] - '0'; return x; };
+			long long ns = ((number(8, 2) * 60 + number(10, 2)) * 60 + number(12, 2)) * 1000000000LL;
+			long long scale = 100000000LL;
+			for (size_t i = 14; i < n && scale > 0; ++i, scale /= 10)
+				ns += (digits[i] - '0') * scale;
+			result = date_ + ats::timestamp_t::duration(ns);
+			return true;
+		}
+
+	private:
+		std::vector<std::string> symbols_;
+		ats::exchange_id_t exchange_id_;                                   // npos to use SenderCompID
+		std::string sender_;                                               // SenderCompID of the last message
+		ats::exchange_id_t sender_id_ = ats::name_registry::npos;
+		std::unordered_map<std::string_view, ats::symbol_id_t> symbol_ids_;  // npos for unwanted symbols
+		std::set<std::string> unwanted_;                                   // names of unwanted symbols seen
+		char date_str_[8] = { };  // cached YYYYMMDD
+		ats::timestamp_t date_;   // midnight of that date
+	};
+}
+}
+
+#endif)";
+
+	// Generates the MarketDataIncrementalRefresh decoder (ats/io/parser/fix_md_incremental_refresh.hpp) from
+	// a QuickFIX data dictionary. Tags and values are taken from the dictionary, which is also checked to
+	// define every field the decoder reads in the entries of NoMDEntries
+	static void generate(const std::string& fix_specs_xml, const std::string& header_file)
+	{
+		dictionary dict(fix_specs_xml);
+
+		const ptree& msg = dict.message("MarketDataIncrementalRefresh");
+		const ptree* group = dict.find_group(msg, "NoMDEntries");
+		if (group == nullptr)
+			throw std::runtime_error("fix_decoder_generator: MarketDataIncrementalRefresh has no NoMDEntries group");
+
+		std::vector<std::string> entry_fields;
+		dict.group_fields(*group, entry_fields);
+		if (entry_fields.empty() || entry_fields.front() != "MDUpdateAction")
+			throw std::runtime_error("fix_decoder_generator: Entries of NoMDEntries are expected to start with MDUpdateAction");
+
+		std::set<std::string> in_group(entry_fields.cbegin(), entry_fields.cend());
+		for (const char* field : { "SecurityDesc", "QuoteCondition", "MDEntryType", "MDEntryPx", "MDEntrySize",
+				"MDPriceLevel", "NumberOfOrders", "AggressorSide" })
+		{
+			if (in_group.find(field) == in_group.cend())
+				throw std::runtime_error(std::string("fix_decoder_generator: NoMDEntries has no field ") + field);
+		}
+
+		std::string code = decoder_template;
+		replace_all(code, "@Dictionary@", boost::filesystem::path(fix_specs_xml).filename().string());
+		replace_all(code, "@MsgType.MarketDataIncrementalRefresh@", msg.get<std::string>("<xmlattr>.msgtype"));
+		for (const char* field : { "MsgType", "MsgSeqNum", "SendingTime", "SenderCompID", "NoMDEntries", "MDUpdateAction",
+				"SecurityDesc", "QuoteCondition", "MDEntryType", "MDEntryPx", "MDEntrySize", "MDPriceLevel",
+				"NumberOfOrders", "AggressorSide" })
+			replace_all(code, std::string("@") + field + "@", std::to_string(dict.tag(field)));
+
+		const std::pair<const char*, const char*> values[] = { { "MDUpdateAction", "NEW" }, { "MDUpdateAction", "CHANGE" },
+				{ "MDUpdateAction", "DELETE" }, { "MDEntryType", "BID" }, { "MDEntryType", "OFFER" }, { "MDEntryType", "TRADE" },
+				{ "QuoteCondition", "EXCHANGE_BEST" }, { "AggressorSide", "SELL" } };
+		for (const auto& value : values)
+			replace_all(code, std::string("@") + value.first + '.' + value.second + '@', std::string(1, dict.value(value.first, value.second)));
+
+		std::ofstream out(header_file, std::ios::binary | std::ios::trunc);
+		out << code;
+		if (!out)
+			throw std::runtime_error("fix_decoder_generator: Cannot write '" + header_file + "'");
+	}
+}
+}
+
+#endif
\ No newline at end of file
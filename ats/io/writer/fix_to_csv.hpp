@@ -56,7 +56,7 @@ namespace ats
 			{
 				for (const auto& m : msg.messages)
 				{
-					csv << m.exchange << ',' << m.symbol << ',';
+					csv << m.exchange() << ',' << m.symbol() << ',';
 					if (print_seq_num)
 						csv << m.seq_number << ',';
 					csv << m.time.to_string("%Y%m%d %H%M%S.%f") << ',' << update_action_to_char(m.update_action) << ','
@@ -0,0 +1,82 @@
+#ifndef LEVEL2_CSV_TO_BINARY_HPP
+#define LEVEL2_CSV_TO_BINARY_HPP
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include <ats/custom_message_readers/level2_message_reader.hpp>
+#include <ats/io/format/level2_binary_format.hpp>
+
+namespace ats
+{
+	// Converts a level2 CSV day file (as produced by transform() in init.hpp) into the binary format
+	// read by ats::l2_binary_message_reader. Returns the number of packets written. The file is written
+	// next to its destination and renamed into place once complete, so that a failed conversion never
+	// leaves a truncated binary file behind to be preferred over the CSV file
+	inline size_t level2_csv_to_binary(const std::string& csv_file, const std::string& binary_file)
+	{
+		boost::filesystem::path tmp(binary_file + ".tmp");
+		std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("level2_csv_to_binary: Cannot open '" + tmp.string() + "'");
+
+		l2_binary::file_header header;
+		std::memcpy(header.magic, l2_binary::file_magic, sizeof(header.magic));
+		header.version = l2_binary::file_version;
+		header.record_size = sizeof(l2_binary::record);
+		header.record_count = 0;
+		header.packet_count = 0;
+		header.records_offset = sizeof(header);
+		header.index_offset = 0;
+
+		// The header is rewritten once the number of records and packets is known
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<l2_binary::packet_index> index;
+		ats::l2_message_reader reader(csv_file, "", "");
+		while (reader.read())
+		{
+			const ats::level2_message_packet& packet = reader.get_last_true_message();
+
+			l2_binary::packet_index entry;
+			entry.time = packet.time.nanoseconds();
+			entry.first_record = header.record_count;
+			index.push_back(entry);
+
+			for (const auto& m : packet.messages)
+			{
+				l2_binary::record r = l2_binary::to_record(m);
+				out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+			}
+			header.record_count += packet.messages.size();
+		}
+
+		// Sentinel entry closing the last packet
+		l2_binary::packet_index sentinel;
+		sentinel.time = index.empty() ? 0 : index.back().time;
+		sentinel.first_record = header.record_count;
+		index.push_back(sentinel);
+
+		header.packet_count = index.size() - 1;
+		header.index_offset = header.records_offset + header.record_count * sizeof(l2_binary::record);
+		out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(l2_binary::packet_index));
+
+		out.seekp(0);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.close();
+		if (!out)
+		{
+			boost::system::error_code ec;
+			boost::filesystem::remove(tmp, ec);
+			throw std::runtime_error("level2_csv_to_binary: Cannot write '" + tmp.string() + "'");
+		}
+		boost::filesystem::rename(tmp, binary_file);
+
+		return header.packet_count;
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,241 @@
+#ifndef PARALLEL_FIX_TO_CSV_HPP
+#define PARALLEL_FIX_TO_CSV_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <stdexcept>
+#include <future>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <unordered_map>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <ats/concurrency/thread_pool.hpp>
+#include <ats/date_time/timestamp.hpp>
+#include <ats/io/parser/fix_md_incremental_refresh.hpp>
+#include <ats/message/level2_message.hpp>
+
+namespace ats {
+namespace parallel_fix_to_csv_detail
+{
+	// CSV lines of a chunk of the log by symbol, in the order of the log
+	typedef std::vector<std::pair<std::string, std::string>> chunk_output;
+
+	inline void append_number(std::string& out, long value)
+	{
+		char buffer[24];
+		out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+	}
+
+	// Converts the lines [begin, end) of a log; the lines of a message are followed by eop_str in the
+	// output of every symbol it has entries for
+	inline chunk_output convert_chunk(const char* begin, const char* end, const std::vector<std::string>& symbols,
+			bool print_seq_num, const std::string& eop_str)
+	{
+		chunk_output output;
+		std::unordered_map<ats::symbol_id_t, size_t> index;  // position of a symbol in output
+		ats::exchange_id_t exchange_id = ats::name_registry::npos;
+		std::string exchange;                                // name of exchange_id
+		ats::fix_md::incremental_refresh_decoder decoder(symbols);
+		ats::level2_message_packet msg;
+		ats::date_time::timestamp_formatter formatter;
+		char time_str[32];
+
+		std::vector<size_t> touched;  // symbols with entries in the current message
+		for (const char* pos = begin; pos < end; )
+		{
+			const char* eol = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+			if (eol == nullptr)
+				eol = end;
+			const char* line = pos;
+			pos = eol < end ? eol + 1 : end;
+			if (eol > line && eol[-1] == '\r')
+				--eol;
+
+			if (!decoder.decode(line, eol, msg) || msg.messages.empty())
+				continue;
+
+			size_t time_len = formatter.format(msg.time, time_str) - time_str;
+			touched.clear();
+			for (const auto& m : msg.messages)
+			{
+				auto it = index.find(m.symbol_id);
+				if (it == index.end())
+				{
+					it = index.insert(std::make_pair(m.symbol_id, output.size())).first;
+					output.emplace_back(m.symbol(), std::string());
+				}
+				if (m.exchange_id != exchange_id)
+				{
+					exchange_id = m.exchange_id;
+					exchange = m.exchange();
+				}
+				if (std::find(touched.cbegin(), touched.cend(), it->second) == touched.cend())
+					touched.push_back(it->second);
+
+				std::string& out = output[it->second].second;
+				out += exchange;
+				out += ',';
+				out += output[it->second].first;
+				out += ',';
+				if (print_seq_num)
+				{
+					append_number(out, m.seq_number);
+					out += ',';
+				}
+				out.append(time_str, time_len);
+				out += ',';
+				out += m.update_action == ats::update_action::New ? 'N' : m.update_action == ats::update_action::Change ? 'C' : 'D';
+				out += ',';
+				out += m.entry_type == ats::entry_type::Bid ? 'B' : m.entry_type == ats::entry_type::Ask ? 'A' : 'T';
+				out += ',';
+				append_number(out, m.price);
+				out += ',';
+				append_number(out, m.quantity);
+				out += ',';
+				append_number(out, m.order_count);
+				out += ',';
+				append_number(out, m.level);
+				out += '\n';
+			}
+			for (size_t i : touched)
+				output[i].second += eop_str;
+		}
+		return output;
+	}
+
+	// Output files of the symbols, of which at most max_open are open at a time: the least recently written
+	// one is closed to open another, and reopened in append mode once written again. A file that cannot be
+	// opened or written throws right away
+	class symbol_files
+	{
+	public:
+		symbol_files(const std::string& directory, size_t max_open)
+			: directory_(directory), max_open_(std::max<size_t>(max_open, 1U)) { }
+
+		void write(const std::string& symbol, const std::string& data)
+		{
+			auto it = files_.find(symbol);
+			if (it == files_.end())
+				it = files_.emplace(symbol, file()).first;
+			file& f = it->second;
+
+			if (f.out.is_open())
+				open_.splice(open_.begin(), open_, f.position);
+			else
+			{
+				if (open_.size() >= max_open_)
+				{
+					close(*open_.back());
+					open_.pop_back();
+				}
+
+				boost::filesystem::path path = boost::filesystem::path(directory_) / (symbol + ".csv");
+				f.out.open(path.string(), std::ios::binary | (f.is_created ? std::ios::app : std::ios::trunc));
+				if (!f.out.is_open())
+					throw std::runtime_error("parallel_fix_to_csv: Cannot open '" + path.string() + "'");
+				f.is_created = true;
+				open_.push_front(&f);
+				f.position = open_.begin();
+			}
+
+			f.out.write(data.data(), data.size());
+			if (!f.out)
+				throw std::runtime_error("parallel_fix_to_csv: Cannot write the file of symbol '" + symbol + "'");
+		}
+
+		void close()
+		{
+			for (file* f : open_)
+				close(*f);
+			open_.clear();
+		}
+
+	private:
+		struct file
+		{
+			std::ofstream out;
+			bool is_created = false;                  // reopened files are appended to
+			std::list<file*>::iterator position;      // in open_, if open
+		};
+
+		void close(file& f)
+		{
+			f.out.close();
+			if (!f.out)
+				throw std::runtime_error("parallel_fix_to_csv: Cannot write a symbol file in '" + directory_ + "'");
+		}
+
+		std::string directory_;
+		size_t max_open_;
+		std::unordered_map<std::string, file> files_;
+		std::list<file*> open_;  // open files, most recently written first
+	};
+}
+}
+
+namespace ats
+{
+	// Parallel counterpart of fix_to_csv based on the generated decoder (see fix_md_incremental_refresh.hpp)
+	// rather than QuickFIX. The log is split at line boundaries into chunks of about chunk_size bytes, which
+	// are converted on a thread pool (one thread per hardware thread if threads is zero) and written in
+	// the order of the log. Symbols (all symbols of the log if there is none) are written into their own
+	// files "<symbol>.csv" in csv_directory in the same pass, of which at most max_open_files are open at a
+	// time (e.g., for a log of thousands of instruments); lines are those of fix_to_csv
+	static void parallel_fix_to_csv(const std::string& fix_file, const std::string& csv_directory,
+			const std::vector<std::string>& symbols = {}, size_t threads = 0, bool print_seq_num = false,
+			const std::string& eop_str = "EOP", size_t chunk_size = 16U << 20, size_t max_open_files = 256)
+	{
+		boost::system::error_code ec;
+		if (boost::filesystem::file_size(fix_file, ec) == 0 || ec)
+			return;
+
+		boost::iostreams::mapped_file_source file(fix_file);
+		const char* pos = file.data();
+		const char* end = pos + file.size();
+
+		ats::thread_pool pool(threads);
+		std::deque<std::future<parallel_fix_to_csv_detail::chunk_output>> chunks;
+		parallel_fix_to_csv_detail::symbol_files files(csv_directory, max_open_files);
+
+		// Chunks are written as soon as they and the chunks before them are converted; the number of
+		// chunks in flight is bounded, so that memory does not grow with the size of the log
+		auto write_chunk = [&]()
+		{
+			for (const auto& output : chunks.front().get())
+				files.write(output.first, output.second);
+			chunks.pop_front();
+		};
+
+		while (pos < end)
+		{
+			const char* chunk_end = end - pos > static_cast<ptrdiff_t>(chunk_size) ? pos + chunk_size : end;
+			if (chunk_end < end)
+			{
+				chunk_end = static_cast<const char*>(std::memchr(chunk_end, '\n', end - chunk_end));
+				chunk_end = chunk_end == nullptr ? end : chunk_end + 1;
+			}
+
+			chunks.push_back(pool.submit([=, &symbols, &eop_str]()
+			{
+				return parallel_fix_to_csv_detail::convert_chunk(pos, chunk_end, symbols, print_seq_num, eop_str);
+			}));
+			pos = chunk_end;
+
+			if (chunks.size() >= 2 * pool.size())
+				write_chunk();
+		}
+
+		while (!chunks.empty())
+			write_chunk();
+
+		files.close();
+	}
+}
+
+#endif
\ No newline at end of file
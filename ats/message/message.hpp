@@ -23,8 +23,12 @@ namespace ats
 	{
 		virtual ~instrument_message() { }
 
-		std::string symbol;
-		std::string exchange;
+		// Names are resolved from the registries, for I/O and logging
+		const std::string& symbol() const { return ats::symbol_registry().name(symbol_id); }
+		const std::string& exchange() const { return ats::exchange_registry().name(exchange_id); }
+
+		ats::symbol_id_t symbol_id = ats::name_registry::npos;
+		ats::exchange_id_t exchange_id = ats::name_registry::npos;
 	};
 
 	template<typename MessageT>
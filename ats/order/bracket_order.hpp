@@ -10,7 +10,7 @@ namespace ats
 	{
 	public:
 		bracket_order(const ats::orderid_t& id, ats::limit_order& lmt_order, ats::stop_order& stp_order)
-			: order(id, lmt_order.symbol(), lmt_order.quantity(), lmt_order.side(), lmt_order.time_in_force())
+			: order(id, lmt_order.symbol_id(), lmt_order.quantity(), lmt_order.side(), lmt_order.time_in_force())
 		{
 			lmt_order.parent_id = id;
 			stp_order.parent_id = id;
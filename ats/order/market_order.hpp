@@ -14,6 +14,10 @@ namespace ats
 				long quantity, ats::order_side side, ats::order_time_in_force time_in_force)
 			: ats::order(id, symbol, quantity, side, time_in_force), fill_price(0) { }
 
+		market_order(const ats::orderid_t& id, ats::symbol_id_t symbol_id,
+				long quantity, ats::order_side side, ats::order_time_in_force time_in_force)
+			: ats::order(id, symbol_id, quantity, side, time_in_force), fill_price(0) { }
+
 		ats::price_t fill_price;
 	};
 }
@@ -16,15 +16,23 @@ namespace ats
 	public:
 		order(const ats::orderid_t& id, const std::string& symbol, long quantity,
 				ats::order_side side, ats::order_time_in_force time_in_force)
-			: id_(id), symbol_(symbol), quantity_(quantity),
-			  side_(side), time_in_force_(time_in_force), transact_time(ats::timestamp_t::now())
+			: order(id, ats::symbol_registry().intern(symbol), quantity, side, time_in_force)
+		{ }
+
+		// Orders created while replaying (e.g., by simulated books) take the interned symbol of a message.
+		// transact_time is left undefined: orders are stamped when sent, from the clock of the portfolio
+		order(const ats::orderid_t& id, ats::symbol_id_t symbol_id, long quantity,
+				ats::order_side side, ats::order_time_in_force time_in_force)
+			: id_(id), symbol_id_(symbol_id), quantity_(quantity),
+			  side_(side), time_in_force_(time_in_force)
 		{ }
 
 	public:
 		virtual ~order() { }
 
 		const ats::orderid_t& id() const { return id_; }
-		const std::string& symbol() const { return symbol_; }
+		const std::string& symbol() const { return ats::symbol_registry().name(symbol_id_); }
+		ats::symbol_id_t symbol_id() const { return symbol_id_; }
 		long quantity() const { return quantity_; }
 		ats::order_side side() const { return side_; }
 		ats::order_time_in_force time_in_force() const { return time_in_force_; }
@@ -61,11 +69,11 @@ namespace ats
 
 	private:
 		ats::orderid_t id_;
-		std::string symbol_;
+		ats::symbol_id_t symbol_id_;
 		long quantity_;
 		ats::order_side side_;
 		ats::order_time_in_force time_in_force_;
-		ats::order_status status_;
+		ats::order_status status_ = ats::order_status::New;
 	};
 }
 
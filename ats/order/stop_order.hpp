@@ -14,6 +14,11 @@ namespace ats
 				ats::price_t stop_price)
 			: ats::order(id, symbol, quantity, side, time_in_force), price_(stop_price) { }
 
+		stop_order(const ats::orderid_t& id, ats::symbol_id_t symbol_id,
+				long quantity, ats::order_side side, ats::order_time_in_force time_in_force,
+				ats::price_t stop_price)
+			: ats::order(id, symbol_id, quantity, side, time_in_force), price_(stop_price) { }
+
 		ats::price_t price() const { return price_; }
 	private:
 		ats::price_t price_;
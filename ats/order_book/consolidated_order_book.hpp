@@ -0,0 +1,102 @@
+#ifndef CONSOLIDATED_ORDERBOOK_HPP
+#define CONSOLIDATED_ORDERBOOK_HPP
+
+#include <functional>
+#include <ats/order_book/detail/consolidated_price_levels.hpp>
+#include <ats/message/level2_message.hpp>
+#include <ats/types.hpp>
+
+namespace ats
+{
+	// Book of a symbol across venues (see order_book::consolidate). It follows the updates of the books of
+	// the venues: after a message has been applied to a venue book, the level at its price is read back,
+	// as is the worst level of the side, which a new level may have pushed out of a book of limited depth
+	class consolidated_order_book
+	{
+	public:
+		typedef ats::order_book_detail::consolidated_price_levels<std::greater<ats::price_t>> bids_type;
+		typedef ats::order_book_detail::consolidated_price_levels<std::less<ats::price_t>> asks_type;
+		typedef ats::order_book_detail::consolidated_price_level price_level_type;
+
+		// To be called before a message is applied to the book of a venue, then end_update after it
+		template<typename book_type>
+		void begin_update(const book_type& book, const ats::level2_message& msg)
+		{
+			is_worst_defined_ = false;
+			if (msg.entry_type == ats::entry_type::Bid && !book.bids().empty())
+			{
+				worst_price_ = book.bids().crbegin()->first;
+				is_worst_defined_ = true;
+			}
+			else if (msg.entry_type == ats::entry_type::Ask && !book.asks().empty())
+			{
+				worst_price_ = book.asks().crbegin()->first;
+				is_worst_defined_ = true;
+			}
+		}
+
+		template<typename book_type>
+		void end_update(ats::exchange_id_t exchange, const book_type& book, const ats::level2_message& msg)
+		{
+			if (msg.entry_type == ats::entry_type::Bid)
+			{
+				refresh(bids_, exchange, book.bids(), msg.price);
+				if (is_worst_defined_ && worst_price_ != msg.price)
+					refresh(bids_, exchange, book.bids(), worst_price_);
+			}
+			else if (msg.entry_type == ats::entry_type::Ask)
+			{
+				refresh(asks_, exchange, book.asks(), msg.price);
+				if (is_worst_defined_ && worst_price_ != msg.price)
+					refresh(asks_, exchange, book.asks(), worst_price_);
+			}
+		}
+
+		// Adds all the levels of the book of a venue, e.g., when rebuilding from scratch
+		template<typename book_type>
+		void add(ats::exchange_id_t exchange, const book_type& book)
+		{
+			for (auto it = book.bids().cbegin(); it != book.bids().cend(); ++it)
+				bids_.set(exchange, it->first, it->second.quantity, it->second.order_count);
+			for (auto it = book.asks().cbegin(); it != book.asks().cend(); ++it)
+				asks_.set(exchange, it->first, it->second.quantity, it->second.order_count);
+		}
+
+		void clear() { bids_.clear(); asks_.clear(); }
+
+		const price_level_type* best_bid() const { return bids_.top_level(); }
+		const price_level_type* best_ask() const { return asks_.top_level(); }
+
+		// Quantities of the best levels levels of a side
+		long bid_depth(size_t levels) const { return bids_.depth(levels); }
+		long ask_depth(size_t levels) const { return asks_.depth(levels); }
+
+		double midpoint() const
+		{
+			return !bids_.empty() && !asks_.empty() ? (double)(best_bid()->price + best_ask()->price) / 2.0 : 0.0;
+		}
+
+		const bids_type& bids() const { return bids_; }
+		const asks_type& asks() const { return asks_; }
+
+	private:
+		template<typename levels_type, typename book_levels_type>
+		static void refresh(levels_type& levels, ats::exchange_id_t exchange, const book_levels_type& book_levels,
+				ats::price_t price)
+		{
+			auto it = book_levels.find(price);
+			if (it != book_levels.cend())
+				levels.set(exchange, price, it->second.quantity, it->second.order_count);
+			else
+				levels.set(exchange, price, 0, 0);
+		}
+
+	private:
+		bids_type bids_;
+		asks_type asks_;
+		ats::price_t worst_price_ = 0;   // worst level of the side being updated, before the update
+		bool is_worst_defined_ = false;
+	};
+}
+
+#endif
\ No newline at end of file
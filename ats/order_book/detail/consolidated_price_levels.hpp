@@ -0,0 +1,119 @@
+#ifndef CONSOLIDATED_PRICE_LEVELS_HPP
+#define CONSOLIDATED_PRICE_LEVELS_HPP
+
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <ats/types.hpp>
+
+namespace ats {
+namespace order_book_detail
+{
+	// Level of a consolidated book: the depth at a price summed over venues, with the share of each venue
+	struct consolidated_price_level
+	{
+		struct venue_level
+		{
+			ats::exchange_id_t exchange;
+			long quantity;
+			unsigned int order_count;
+		};
+
+		ats::price_t price;
+		long quantity = 0;
+		unsigned int order_count = 0;
+		std::vector<venue_level> venues;  // venues quoting the price, in the order they joined it
+
+		explicit consolidated_price_level(ats::price_t price = 0) : price(price) { }
+
+		const venue_level* get(ats::exchange_id_t exchange) const
+		{
+			auto it = std::find_if(venues.cbegin(), venues.cend(),
+				[exchange](const venue_level& v) { return v.exchange == exchange; });
+			return it != venues.cend() ? &*it : nullptr;
+		}
+	};
+
+	// Side of a consolidated book. Levels are set venue by venue from the levels of their books, so that
+	// each update of a venue changes one entry of one level instead of the side being merged again
+	template<typename compare = std::less<ats::price_t>>
+	class consolidated_price_levels
+	{
+	public:
+		typedef ats::order_book_detail::consolidated_price_level price_level_type;
+		typedef typename std::map<ats::price_t, price_level_type, compare> container_type;
+		typedef typename container_type::iterator iterator;
+		typedef typename container_type::const_iterator const_iterator;
+
+		// Sets the depth of a venue at a price; a venue with no quantity left is removed from the level
+		void set(ats::exchange_id_t exchange, ats::price_t price, long quantity, unsigned int order_count)
+		{
+			auto it = levels_.find(price);
+			if (it == levels_.end())
+			{
+				if (quantity <= 0)
+					return;
+				it = levels_.emplace(price, price_level_type(price)).first;
+			}
+
+			price_level_type& level = it->second;
+			auto venue = std::find_if(level.venues.begin(), level.venues.end(),
+				[exchange](const typename price_level_type::venue_level& v) { return v.exchange == exchange; });
+			if (venue != level.venues.end())
+			{
+				level.quantity -= venue->quantity;
+				level.order_count -= venue->order_count;
+				if (quantity > 0)
+				{
+					venue->quantity = quantity;
+					venue->order_count = order_count;
+				}
+				else
+					level.venues.erase(venue);
+			}
+			else if (quantity > 0)
+				level.venues.push_back({ exchange, quantity, order_count });
+
+			if (level.venues.empty())
+				levels_.erase(it);
+			else
+			{
+				level.quantity += quantity > 0 ? quantity : 0;
+				level.order_count += quantity > 0 ? order_count : 0;
+			}
+		}
+
+		// iterators
+		iterator begin() { return levels_.begin(); }
+		const_iterator cbegin() const { return levels_.cbegin(); }
+		iterator end() { return levels_.end(); }
+		const_iterator cend() const { return levels_.cend(); }
+
+		bool empty() const { return levels_.empty(); }
+		size_t size() const { return levels_.size(); }
+		void clear() { levels_.clear(); }
+
+		const_iterator find(ats::price_t price) const { return levels_.find(price); }
+
+		// Best level, nullptr if the side is empty
+		const price_level_type* top_level() const
+		{
+			return !levels_.empty() ? &levels_.cbegin()->second : nullptr;
+		}
+
+		// Quantity of the best levels levels
+		long depth(size_t levels) const
+		{
+			long quantity = 0;
+			for (auto it = levels_.cbegin(); it != levels_.cend() && levels > 0; ++it, --levels)
+				quantity += it->second.quantity;
+			return quantity;
+		}
+
+	private:
+		container_type levels_;
+	};
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,265 @@
+#ifndef FIXED_PRICE_LEVELS_HPP
+#define FIXED_PRICE_LEVELS_HPP
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <ats/message/level2_message.hpp>
+#include <ats/order_book/detail/price_level.hpp>
+#include <ats/io/format/book_snapshot.hpp>
+#include <ats/types.hpp>
+
+namespace ats {
+namespace order_book_detail
+{
+	// price_levels with at most depth levels kept inline in a sorted array, for books whose depth is known
+	// at compile time: levels are inserted and deleted by shifting the array, and the level of a given
+	// rank is at its index. The prices are also kept in a separate array, padded with the worst possible
+	// price, so that they are searched four at a time with SSE2
+	template<size_t depth, typename compare = std::less<ats::price_t>>
+	class fixed_price_levels
+	{
+		static_assert(depth > 0, "fixed_price_levels: Depth must be positive");
+	public:
+		typedef typename ats::order_book_detail::price_level price_level_type;
+		typedef std::pair<ats::price_t, price_level_type> value_type;
+		typedef value_type* iterator;
+		typedef const value_type* const_iterator;
+		typedef std::reverse_iterator<iterator> reverse_iterator;
+		typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+		fixed_price_levels(size_t max_levels = depth)
+			: max_levels_(max_levels)
+		{
+			if (max_levels_ > depth)
+				throw std::invalid_argument("fixed_price_levels: Book depth " + std::to_string(max_levels_) +
+					" exceeds " + std::to_string(depth));
+			clear();
+		}
+
+		void update(const ats::level2_message& msg)
+		{
+			// Trade messages are not used to update order book
+			if (msg.entry_type == ats::entry_type::Trade) return;
+
+			switch (msg.update_action)
+			{
+			case ats::update_action::New:
+				insert_level(msg.price, price_level_type(msg.price, msg.quantity, msg.order_count));
+				break;
+			case ats::update_action::Change:
+				change_level(msg.price, msg.quantity, msg.order_count);
+				break;
+			case ats::update_action::Delete:
+				delete_level(msg.price);
+				break;
+			default:
+				break;
+			}
+		}
+
+		void update2(ats::level2_message& msg)
+		{
+			// Trade messages are not used to update order book
+			if (msg.entry_type == ats::entry_type::Trade) return;
+
+			if (msg.update_action == ats::update_action::New)
+				insert_level(msg.price, price_level_type(msg.price, msg.quantity, msg.order_count));
+			else if (msg.update_action == ats::update_action::Change)
+			{
+				auto it = find(msg.price);
+				if (it != end())
+				{
+					long qty_delta = msg.quantity - it->second.quantity;
+					long oct_delta = msg.order_count - it->second.order_count;
+
+					it->second.quantity = msg.quantity;
+					it->second.order_count = msg.order_count;
+
+					msg.quantity = qty_delta;
+					msg.order_count = oct_delta;
+				}
+				else
+					insert_level(msg.price, price_level_type(msg.price, msg.quantity, msg.order_count));
+			}
+			else if (msg.update_action == ats::update_action::Delete)
+			{
+				delete_level(msg.price);
+				msg.quantity = -msg.quantity;
+			}
+		}
+
+	private:
+		void change_level(ats::price_t price, long new_quantity, uint16_t new_order_count)
+		{
+			auto it = find(price);
+			if (it != end())
+			{
+				it->second.quantity = new_quantity;
+				it->second.order_count = new_order_count;
+			}
+			else
+				insert_level(price, price_level_type(price, new_quantity, new_order_count));
+		}
+
+		// As with price_levels, an existing level is kept and the worst level is dropped once there are
+		// more than max_levels levels
+		void insert_level(ats::price_t price, const price_level_type& level)
+		{
+			size_t index = rank(price);
+			if (index >= max_levels_ || (index < size_ && prices_[index] == price))
+				return;
+
+			if (size_ == max_levels_)
+				--size_;
+			std::copy_backward(prices_ + index, prices_ + size_, prices_ + size_ + 1);
+			std::copy_backward(levels_ + index, levels_ + size_, levels_ + size_ + 1);
+			prices_[index] = price;
+			levels_[index] = value_type(price, level);
+			++size_;
+		}
+
+		void delete_level(ats::price_t price)
+		{
+			size_t index = rank(price);
+			if (index < size_ && prices_[index] == price)
+			{
+				std::copy(prices_ + index + 1, prices_ + size_, prices_ + index);
+				std::copy(levels_ + index + 1, levels_ + size_, levels_ + index);
+				--size_;
+				prices_[size_] = worst_price();
+			}
+		}
+
+		// Price that no price is behind, used as the padding of prices_
+		static constexpr ats::price_t worst_price()
+		{
+			return compare()(std::numeric_limits<ats::price_t>::lowest(), std::numeric_limits<ats::price_t>::max()) ?
+				std::numeric_limits<ats::price_t>::max() : std::numeric_limits<ats::price_t>::lowest();
+		}
+
+		// Number of levels ahead of a price, i.e., the index of the level at the price if there is one
+		size_t rank(ats::price_t price) const
+		{
+#ifdef __SSE2__
+			constexpr bool is_less = std::is_same<compare, std::less<ats::price_t>>::value;
+			constexpr bool is_greater = std::is_same<compare, std::greater<ats::price_t>>::value;
+			if constexpr ((is_less || is_greater) && sizeof(ats::price_t) == 4)
+			{
+				const __m128i key = _mm_set1_epi32(price);
+				int count = 0;
+				for (size_t i = 0; i < padded_depth; i += 4)
+				{
+					__m128i prices = _mm_load_si128(reinterpret_cast<const __m128i*>(prices_ + i));
+					__m128i ahead;
+					if constexpr (is_less)
+						ahead = _mm_cmplt_epi32(prices, key);
+					else
+						ahead = _mm_cmpgt_epi32(prices, key);
+					count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(ahead)));
+				}
+				return static_cast<size_t>(count);
+			}
+#endif
+			size_t index = 0;
+			while (index < size_ && compare()(prices_[index], price))
+				++index;
+			return index;
+		}
+
+	public:
+		// iterators
+		iterator begin() { return levels_; }
+		const_iterator cbegin() const { return levels_; }
+		iterator end() { return levels_ + size_; }
+		const_iterator cend() const { return levels_ + size_; }
+		reverse_iterator rbegin() { return reverse_iterator(end()); }
+		const_reverse_iterator crbegin() const { return const_reverse_iterator(cend()); }
+		reverse_iterator rend() { return reverse_iterator(begin()); }
+		const_reverse_iterator crend() const { return const_reverse_iterator(cbegin()); }
+
+		price_level_type& at(ats::price_t price) { return const_cast<price_level_type&>(std::as_const(*this).at(price)); }
+		const price_level_type& at(ats::price_t price) const
+		{
+			auto it = find(price);
+			if (it == cend())
+				throw std::out_of_range("fixed_price_levels: No level at " + std::to_string(price));
+			return it->second;
+		}
+
+		bool empty() const { return size_ == 0; }
+
+		void clear()
+		{
+			size_ = 0;
+			std::fill(prices_, prices_ + padded_depth, worst_price());
+		}
+
+		iterator find(ats::price_t price)
+		{
+			size_t index = rank(price);
+			return index < size_ && prices_[index] == price ? levels_ + index : end();
+		}
+
+		const_iterator find(ats::price_t price) const
+		{
+			size_t index = rank(price);
+			return index < size_ && prices_[index] == price ? levels_ + index : cend();
+		}
+
+		size_t size() const { return size_; }
+		size_t displayed_depth() const { return max_levels_; }
+
+		// Level of a rank counted from 1 (as with price_levels, 0 is the best level too)
+		iterator get_level(size_t index)
+		{
+			return index > size_ ? end() : begin() + (index > 0 ? index - 1 : 0);
+		}
+
+		const_iterator get_level(size_t index) const
+		{
+			return index > size_ ? cend() : cbegin() + (index > 0 ? index - 1 : 0);
+		}
+
+		// Snapshot of the levels, in the format of price_levels
+		void save(std::ostream& out) const
+		{
+			ats::book_snapshot::write(out, static_cast<uint64_t>(size_));
+			for (size_t i = 0; i < size_; ++i)
+			{
+				ats::book_snapshot::write(out, static_cast<int32_t>(levels_[i].second.price));
+				ats::book_snapshot::write(out, static_cast<int64_t>(levels_[i].second.quantity));
+				ats::book_snapshot::write(out, static_cast<uint32_t>(levels_[i].second.order_count));
+			}
+		}
+
+		void load(std::istream& in)
+		{
+			clear();
+			for (uint64_t n = ats::book_snapshot::read<uint64_t>(in); n > 0; --n)
+			{
+				ats::price_t price = ats::book_snapshot::read<int32_t>(in);
+				long quantity = ats::book_snapshot::read<int64_t>(in);
+				unsigned int order_count = ats::book_snapshot::read<uint32_t>(in);
+				insert_level(price, price_level_type(price, quantity, order_count));
+			}
+		}
+
+	private:
+		static constexpr size_t padded_depth = (depth + 3) / 4 * 4;
+
+		size_t max_levels_;
+		size_t size_ = 0;
+		alignas(16) ats::price_t prices_[padded_depth];  // prices of the levels, then worst_price()
+		value_type levels_[depth];
+	};
+}
+}
+
+#endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <ats/message/level2_message.hpp>
 #include <ats/order_book/detail/price_level.hpp>
+#include <ats/io/format/book_snapshot.hpp>
 #include <ats/types.hpp>
 
 namespace ats {
@@ -192,6 +193,30 @@ namespace order_book_detail
 		}
 
 		container_type& levels() { return levels_; }
+
+		// Snapshot of the levels (see book_snapshot.hpp)
+		void save(std::ostream& out) const
+		{
+			ats::book_snapshot::write(out, static_cast<uint64_t>(levels_.size()));
+			for (const auto& level : levels_)
+			{
+				ats::book_snapshot::write(out, static_cast<int32_t>(level.second.price));
+				ats::book_snapshot::write(out, static_cast<int64_t>(level.second.quantity));
+				ats::book_snapshot::write(out, static_cast<uint32_t>(level.second.order_count));
+			}
+		}
+
+		void load(std::istream& in)
+		{
+			levels_.clear();
+			for (uint64_t n = ats::book_snapshot::read<uint64_t>(in); n > 0; --n)
+			{
+				ats::price_t price = ats::book_snapshot::read<int32_t>(in);
+				long quantity = ats::book_snapshot::read<int64_t>(in);
+				unsigned int order_count = ats::book_snapshot::read<uint32_t>(in);
+				levels_.emplace_hint(levels_.end(), price, price_level_type(price, quantity, order_count));
+			}
+		}
 	
 	private:
 		size_t max_levels_;
@@ -1,181 +1,257 @@
-#ifndef EXCHANGE_ORDERBOOK_HPP
-#define EXCHANGE_ORDERBOOK_HPP
-
-#include <iosfwd>
-#include <fstream>
-#include <ats/order_book/detail/price_levels.hpp>
-#include <ats/message/level2_message.hpp>
-#include <ats/types.hpp>
-
-namespace ats
-{
-	class exchange_order_book
-	{
-	public:
-		typedef ats::order_book_detail::price_levels<std::greater<ats::price_t>> bids_type;
-		typedef ats::order_book_detail::price_levels<std::less<ats::price_t>> asks_type;
-		typedef bids_type::iterator bid_iterator;
-		typedef bids_type::const_iterator bid_const_iterator;
-		typedef asks_type::iterator ask_iterator;
-		typedef asks_type::const_iterator ask_const_iterator;
-		typedef ats::order_book_detail::price_level price_level_type;
-
-		exchange_order_book(const ats::symbol_key& symbol, const std::string& exchange, size_t book_depth)
-			: max_levels_(book_depth), bids_(book_depth), asks_(book_depth),
-			  symbol_(symbol), exchange_(exchange) { }
-
-		void update(const ats::level2_message& msg)
-		{
-			last_update_time_ = msg.time;
-
-			if (msg.entry_type == ats::entry_type::Bid)
-				bids_.update(msg);
-			else if (msg.entry_type == ats::entry_type::Ask)
-				asks_.update(msg);
-		}
-
-		void update2(ats::level2_message& msg)
-		{
-			last_update_time_ = msg.time;
-
-			if (msg.entry_type == ats::entry_type::Bid)
-				bids_.update2(msg);
-			else if (msg.entry_type == ats::entry_type::Ask)
-				asks_.update2(msg);
-			else if (msg.entry_type == ats::entry_type::Trade && msg.aggressor_side == 0)
-			{
-				if (!asks_.empty() && msg.price >= asks_.cbegin()->first)
-					msg.aggressor_side = 1;
-				else if (!bids_.empty() && msg.price <= bids_.cbegin()->first)
-					msg.aggressor_side = -1;
-			}
-		}
-
-		bid_iterator begin_bid() { return bids_.begin(); }
-		bid_const_iterator cbegin_bid() const { return bids_.cbegin(); }
-		ask_iterator begin_ask() { return asks_.begin(); }
-		ask_const_iterator cbegin_ask() const { return asks_.cbegin(); }
-		bid_iterator end_bid() { return bids_.end(); }
-		bid_const_iterator cend_bid() const { return bids_.cend(); }
-		ask_iterator end_ask() { return asks_.end(); }
-		ask_const_iterator cend_ask() const { return asks_.cend(); }
-
-//		ats::price_t best_bid_price() const { return cbegin_bid()->first; }
-//		ats::price_t best_ask_price() const { return cbegin_ask()->first; }
-//		const price_level_type& best_bid_depth() const { return cbegin_bid()->second; }
-//		const price_level_type& best_ask_depth() const { return cbegin_ask()->second; }
-
-		size_t displayed_depth() const { return max_levels_; }
-
-		void clear() { bids_.clear(); asks_.clear(); }
-
-		int bid_ask_spread() const { return asks_.cbegin()->first - bids_.cbegin()->first; }
-
-/*		const level_depth& depth_at(const price_t& price, const book_side& side) const
-		{
-			return (side == book_side::bid) ? *bids.find(price) : *asks.find(price);
-		}*/
-
-		const price_level_type* best_bid() const
-		{
-			return !bids_.empty() ? &bids_.cbegin()->second : nullptr;
-		}
-
-		const price_level_type* best_ask() const
-		{
-			return !asks_.empty() ? &asks_.cbegin()->second : nullptr;
-		}
-
-		const price_level_type* bid_at(ats::price_t price) const
-		{
-			auto it = bids_.find(price);
-			return it != bids_.cend() ? &it->second : nullptr;
-		}
-
-		const price_level_type* ask_at(ats::price_t price) const
-		{
-			auto it = asks_.find(price);
-			return it != asks_.cend() ? &it->second : nullptr;
-		}
-
-
-		double midpoint() const
-		{
-			return !bids_.empty() && !asks_.empty() ? (double)(bids_.cbegin()->first + asks_.cbegin()->first) / 2.0 : 0.0;
-		}
-
-		friend std::ostream& operator<<(std::ostream& os, const ats::exchange_order_book& book)
-		{
-			std::vector<std::string> bids;
-			std::vector<std::string> asks;
-
-			std::stringstream ss;
-			size_t max_bid_len = 0;
-			for (auto it = book.bids().cbegin(); it != book.bids().cend(); ++it)
-			{
-				ss << it->first << "(" << it->second.quantity << ")";
-				std::string text = ss.str();
-				if (text.length() > max_bid_len)
-					max_bid_len = text.length();
-				bids.push_back(text);
-				ss.str("");
-				ss.clear();
-			}
-
-			for (auto it = book.asks().cbegin(); it != book.asks().cend(); ++it)
-			{
-				ss << it->first << "(" << it->second.quantity << ")";
-				asks.push_back(ss.str());
-				ss.str("");
-				ss.clear();
-			}
-
-			auto it_b = bids.begin();
-			auto it_a = asks.begin();
-			for (; it_b != bids.end() && it_a != asks.end(); ++it_b, ++it_a)
-			{
-				os << *it_b;
-				size_t dl = max_bid_len - it_b->length();
-				for (size_t i = 0; i < dl; ++i)
-					os << " ";
-				os << " | " << *it_a << '\n';
-			}
-
-			for (; it_b != bids.end(); ++it_b)
-			{
-				os << *it_b;
-				size_t dl = max_bid_len - it_b->length();
-				for (size_t i = 0; i < dl; ++i)
-					os << " ";
-				os << " |\n";
-			}
-
-			for (; it_a != asks.end(); ++it_a)
-			{
-				for (size_t i = 0; i < max_bid_len; ++i)
-					os << " ";
-				os << " | " << *it_a << '\n';
-			}
-
-			return os;
-		}
-
-		bids_type& bids() { return bids_; }
-		const bids_type& bids() const { return bids_; }
-		asks_type& asks() { return asks_; }
-		const asks_type& asks() const { return asks_; }
-		const ats::symbol_key& symbol() const { return symbol_; }
-		const std::string& exchange() const { return exchange_; }
-		const ats::timestamp_t& last_update_time() const { return last_update_time_; }
-
-	private:
-		size_t max_levels_;
-		bids_type bids_;
-		asks_type asks_;
-		ats::symbol_key symbol_;
-		std::string exchange_;
-		ats::timestamp_t last_update_time_;
-	};
-}
-
+#ifndef EXCHANGE_ORDERBOOK_HPP
+#define EXCHANGE_ORDERBOOK_HPP
+
+#include <iosfwd>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <type_traits>
+#include <ats/order_book/detail/price_levels.hpp>
+#include <ats/order_book/detail/fixed_price_levels.hpp>
+#include <ats/message/level2_message.hpp>
+#include <ats/types.hpp>
+
+namespace ats
+{
+	// Book of a symbol at an exchange. With a depth known at compile time, the sides keep at most depth
+	// levels inline (see fixed_price_levels) and book_depth may not exceed it; with depth 0 (the default),
+	// they are trees of book_depth levels
+	template<size_t depth = 0>
+	class basic_exchange_order_book
+	{
+	public:
+		typedef typename std::conditional<depth == 0,
+			ats::order_book_detail::price_levels<std::greater<ats::price_t>>,
+			ats::order_book_detail::fixed_price_levels<depth, std::greater<ats::price_t>>>::type bids_type;
+		typedef typename std::conditional<depth == 0,
+			ats::order_book_detail::price_levels<std::less<ats::price_t>>,
+			ats::order_book_detail::fixed_price_levels<depth, std::less<ats::price_t>>>::type asks_type;
+		typedef typename bids_type::iterator bid_iterator;
+		typedef typename bids_type::const_iterator bid_const_iterator;
+		typedef typename asks_type::iterator ask_iterator;
+		typedef typename asks_type::const_iterator ask_const_iterator;
+		typedef ats::order_book_detail::price_level price_level_type;
+
+		basic_exchange_order_book(const ats::symbol_key& symbol, const std::string& exchange, size_t book_depth)
+			: max_levels_(book_depth), bids_(book_depth), asks_(book_depth),
+			  symbol_(symbol), exchange_(exchange) { }
+
+		void update(const ats::level2_message& msg)
+		{
+			last_update_time_ = msg.time;
+			track_change(msg);
+
+			if (msg.entry_type == ats::entry_type::Bid)
+				bids_.update(msg);
+			else if (msg.entry_type == ats::entry_type::Ask)
+				asks_.update(msg);
+		}
+
+		void update2(ats::level2_message& msg)
+		{
+			last_update_time_ = msg.time;
+			track_change(msg);
+
+			if (msg.entry_type == ats::entry_type::Bid)
+				bids_.update2(msg);
+			else if (msg.entry_type == ats::entry_type::Ask)
+				asks_.update2(msg);
+			else if (msg.entry_type == ats::entry_type::Trade && msg.aggressor_side == 0)
+			{
+				if (!asks_.empty() && msg.price >= asks_.cbegin()->first)
+					msg.aggressor_side = 1;
+				else if (!bids_.empty() && msg.price <= bids_.cbegin()->first)
+					msg.aggressor_side = -1;
+			}
+		}
+
+		bid_iterator begin_bid() { return bids_.begin(); }
+		bid_const_iterator cbegin_bid() const { return bids_.cbegin(); }
+		ask_iterator begin_ask() { return asks_.begin(); }
+		ask_const_iterator cbegin_ask() const { return asks_.cbegin(); }
+		bid_iterator end_bid() { return bids_.end(); }
+		bid_const_iterator cend_bid() const { return bids_.cend(); }
+		ask_iterator end_ask() { return asks_.end(); }
+		ask_const_iterator cend_ask() const { return asks_.cend(); }
+
+//		ats::price_t best_bid_price() const { return cbegin_bid()->first; }
+//		ats::price_t best_ask_price() const { return cbegin_ask()->first; }
+//		const price_level_type& best_bid_depth() const { return cbegin_bid()->second; }
+//		const price_level_type& best_ask_depth() const { return cbegin_ask()->second; }
+
+		size_t displayed_depth() const { return max_levels_; }
+
+		// Changes made by the updates since clear_changes(). Only the top levels levels are tracked
+		// (none by default), so that books nobody watches do not pay for it
+		void track_depth(size_t levels) { tracked_depth_ = levels; }
+		size_t tracked_depth() const { return tracked_depth_; }
+
+		// Best level (1 is the top of the book) of either side that changed, 0 if none of the tracked did
+		size_t changed_level() const { return changed_level_; }
+		bool bbo_changed() const { return changed_level_ == 1; }
+		bool depth_changed(size_t levels) const { return changed_level_ != 0 && changed_level_ <= levels; }
+		bool has_trade() const { return has_trade_; }
+
+		void clear_changes()
+		{
+			changed_level_ = 0;
+			has_trade_ = false;
+		}
+
+		void clear() { bids_.clear(); asks_.clear(); }
+
+		int bid_ask_spread() const { return asks_.cbegin()->first - bids_.cbegin()->first; }
+
+/*		const level_depth& depth_at(const price_t& price, const book_side& side) const
+		{
+			return (side == book_side::bid) ? *bids.find(price) : *asks.find(price);
+		}*/
+
+		const price_level_type* best_bid() const
+		{
+			return !bids_.empty() ? &bids_.cbegin()->second : nullptr;
+		}
+
+		const price_level_type* best_ask() const
+		{
+			return !asks_.empty() ? &asks_.cbegin()->second : nullptr;
+		}
+
+		const price_level_type* bid_at(ats::price_t price) const
+		{
+			auto it = bids_.find(price);
+			return it != bids_.cend() ? &it->second : nullptr;
+		}
+
+		const price_level_type* ask_at(ats::price_t price) const
+		{
+			auto it = asks_.find(price);
+			return it != asks_.cend() ? &it->second : nullptr;
+		}
+
+
+		double midpoint() const
+		{
+			return !bids_.empty() && !asks_.empty() ? (double)(bids_.cbegin()->first + asks_.cbegin()->first) / 2.0 : 0.0;
+		}
+
+		friend std::ostream& operator<<(std::ostream& os, const basic_exchange_order_book& book)
+		{
+			std::vector<std::string> bids;
+			std::vector<std::string> asks;
+
+			std::stringstream ss;
+			size_t max_bid_len = 0;
+			for (auto it = book.bids().cbegin(); it != book.bids().cend(); ++it)
+			{
+				ss << it->first << "(" << it->second.quantity << ")";
+				std::string text = ss.str();
+				if (text.length() > max_bid_len)
+					max_bid_len = text.length();
+				bids.push_back(text);
+				ss.str("");
+				ss.clear();
+			}
+
+			for (auto it = book.asks().cbegin(); it != book.asks().cend(); ++it)
+			{
+				ss << it->first << "(" << it->second.quantity << ")";
+				asks.push_back(ss.str());
+				ss.str("");
+				ss.clear();
+			}
+
+			auto it_b = bids.begin();
+			auto it_a = asks.begin();
+			for (; it_b != bids.end() && it_a != asks.end(); ++it_b, ++it_a)
+			{
+				os << *it_b;
+				size_t dl = max_bid_len - it_b->length();
+				for (size_t i = 0; i < dl; ++i)
+					os << " ";
+				os << " | " << *it_a << '\n';
+			}
+
+			for (; it_b != bids.end(); ++it_b)
+			{
+				os << *it_b;
+				size_t dl = max_bid_len - it_b->length();
+				for (size_t i = 0; i < dl; ++i)
+					os << " ";
+				os << " |\n";
+			}
+
+			for (; it_a != asks.end(); ++it_a)
+			{
+				for (size_t i = 0; i < max_bid_len; ++i)
+					os << " ";
+				os << " | " << *it_a << '\n';
+			}
+
+			return os;
+		}
+
+		bids_type& bids() { return bids_; }
+		const bids_type& bids() const { return bids_; }
+		asks_type& asks() { return asks_; }
+		const asks_type& asks() const { return asks_; }
+		const ats::symbol_key& symbol() const { return symbol_; }
+		const std::string& exchange() const { return exchange_; }
+		const ats::timestamp_t& last_update_time() const { return last_update_time_; }
+
+		// Snapshot of the book (see book_snapshot.hpp); the symbol, exchange and depth are those of the
+		// book the snapshot is loaded into
+		void save(std::ostream& out) const
+		{
+			ats::book_snapshot::write(out, last_update_time_);
+			bids_.save(out);
+			asks_.save(out);
+		}
+
+		void load(std::istream& in)
+		{
+			ats::book_snapshot::read(in, last_update_time_);
+			bids_.load(in);
+			asks_.load(in);
+		}
+
+	private:
+		void track_change(const ats::level2_message& msg)
+		{
+			if (msg.entry_type == ats::entry_type::Bid)
+				track_level(bids_, msg.price, std::greater<ats::price_t>());
+			else if (msg.entry_type == ats::entry_type::Ask)
+				track_level(asks_, msg.price, std::less<ats::price_t>());
+			else if (msg.entry_type == ats::entry_type::Trade)
+				has_trade_ = true;
+		}
+
+		// The level of a price is one more than the number of levels ahead of it, which are only counted
+		// as far as a change could still be the best one
+		template<typename levels_type, typename compare>
+		void track_level(const levels_type& levels, ats::price_t price, compare is_ahead)
+		{
+			size_t last = changed_level_ != 0 ? std::min(changed_level_ - 1, tracked_depth_) : tracked_depth_;
+			size_t level = 1;
+			for (auto it = levels.cbegin(); level <= last && it != levels.cend() && is_ahead(it->first, price); ++it)
+				++level;
+			if (level <= last)
+				changed_level_ = level;
+		}
+
+	private:
+		size_t max_levels_;
+		bids_type bids_;
+		asks_type asks_;
+		ats::symbol_key symbol_;
+		std::string exchange_;
+		ats::timestamp_t last_update_time_;
+		size_t tracked_depth_ = 0;
+		size_t changed_level_ = 0;
+		bool has_trade_ = false;
+	};
+
+	typedef basic_exchange_order_book<> exchange_order_book;
+}
+
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <unordered_map>
 #include "exchange_order_book.hpp"
+#include "consolidated_order_book.hpp"
 #include <ats/message/level2_message.hpp>
 #include <ats/types.hpp>
 
@@ -11,43 +12,101 @@ namespace ats
 	class order_book
 	{
 	public:
+		typedef std::unordered_map<ats::exchange_id_t, ats::exchange_order_book> container_type;
+		typedef container_type::iterator iterator;
+		typedef container_type::const_iterator const_iterator;
+
 		order_book(const ats::symbol_key& symbol) : symbol_(symbol) { }
 
 		const ats::symbol_key& symbol() const { return symbol_; }
 
 		void add_order_book(const std::string& exchange, size_t book_depth)
 		{
-			orderbooks_.insert(std::make_pair(exchange, ats::exchange_order_book(symbol_, exchange, book_depth)));
+			orderbooks_.insert(std::make_pair(ats::exchange_registry().intern(exchange),
+				ats::exchange_order_book(symbol_, exchange, book_depth)));
 		}
 
-		ats::exchange_order_book* get(const std::string& exchange)
+		ats::exchange_order_book* get(ats::exchange_id_t exchange)
 		{
 			auto it = orderbooks_.find(exchange);
 			return it != orderbooks_.cend() ? &it->second : nullptr;
 		}
 
-		const ats::exchange_order_book* get(const std::string& exchange) const
+		const ats::exchange_order_book* get(ats::exchange_id_t exchange) const
 		{
 			auto it = orderbooks_.find(exchange);
 			return it != orderbooks_.cend() ? &it->second : nullptr;
 		}
 
+		ats::exchange_order_book* get(const std::string& exchange)
+		{
+			return get(ats::exchange_registry().find(exchange));
+		}
+
+		const ats::exchange_order_book* get(const std::string& exchange) const
+		{
+			return get(ats::exchange_registry().find(exchange));
+		}
+
+		// Books by interned exchange
+		iterator begin() { return orderbooks_.begin(); }
+		iterator end() { return orderbooks_.end(); }
+		const_iterator cbegin() const { return orderbooks_.cbegin(); }
+		const_iterator cend() const { return orderbooks_.cend(); }
+
 		void update(const ats::level2_message& msg)
 		{
-			ats::exchange_order_book* book = get(msg.exchange);
-			if (book != nullptr)
+			ats::exchange_order_book* book = get(msg.exchange_id);
+			if (book == nullptr)
+				return;
+
+			if (!is_consolidated_)
+				book->update(msg);
+			else
+			{
+				consolidated_.begin_update(*book, msg);
 				book->update(msg);
+				consolidated_.end_update(msg.exchange_id, *book, msg);
+			}
 		}
 
 		void update2(ats::level2_message& msg)
 		{
-			ats::exchange_order_book* book = get(msg.exchange);
-			if (book != nullptr)
+			ats::exchange_order_book* book = get(msg.exchange_id);
+			if (book == nullptr)
+				return;
+
+			if (!is_consolidated_)
+				book->update2(msg);
+			else
+			{
+				// update2 turns the message into deltas, so the consolidated book is given the original
+				ats::level2_message original = msg;
+				consolidated_.begin_update(*book, original);
 				book->update2(msg);
+				consolidated_.end_update(original.exchange_id, *book, original);
+			}
 		}
+
+		// Keeps the consolidated book of the venues from now on (it is not kept by default, as books
+		// of a single venue do not need it). Books changed other than by update or update2 (e.g., loaded
+		// from a snapshot) require calling it again to rebuild the consolidated book
+		void consolidate()
+		{
+			is_consolidated_ = true;
+			consolidated_.clear();
+			for (const auto& book : orderbooks_)
+				consolidated_.add(book.first, book.second);
+		}
+
+		bool is_consolidated() const { return is_consolidated_; }
+		const ats::consolidated_order_book& consolidated() const { return consolidated_; }
+
 	private:
 		ats::symbol_key symbol_;
-		std::unordered_map<std::string, ats::exchange_order_book> orderbooks_;
+		container_type orderbooks_;  // by interned exchange
+		ats::consolidated_order_book consolidated_;
+		bool is_consolidated_ = false;
 	};
 }
 
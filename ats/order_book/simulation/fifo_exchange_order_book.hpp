@@ -2,19 +2,24 @@
 #define FIFO_EXCHANGE_ORDERBOOK_HPP
 
 #include <string>
+#include <stdexcept>
 #include "sim_book.hpp"
 #include <ats/order_book/exchange_order_book.hpp>
 
 namespace ats {
 namespace sim
 {
-	class fifo_exchange_order_book
+	// Exchange book with simulated queues kept in a sim_book_type (see basic_sim_book); the tick size of
+	// info is used by the ladders of tick_sim_book
+	template<typename sim_book_type = ats::sim::sim_book>
+	class basic_fifo_exchange_order_book
 	{
 	public:
-		typedef std::unordered_map<ats::orderid_t, price_level::iterator> order_container;
+		typedef ats::sim::price_level::order_container order_container;
 
-		fifo_exchange_order_book(const ats::symbol_key& symbol, const std::string& exchange, size_t book_depth)
-			: book_(symbol, exchange, book_depth) { }
+		basic_fifo_exchange_order_book(const ats::symbol_key& symbol, const std::string& exchange, size_t book_depth,
+				const ats::metainfo& info = ats::metainfo())
+			: book_(symbol, exchange, book_depth), sim_book_(info) { }
 
 		void add_order(const ats::limit_order& order);
 		void cancel_order(const ats::orderid_t& id, const ats::timestamp_t& time)
@@ -22,6 +27,13 @@ namespace sim
 
 		void update(const ats::level2_message& msg);
 
+		// Message with the change of quantity of a level instead of its new quantity, made from the
+		// exchange book before the message is applied to it
+		static ats::level2_message make_delta(const ats::exchange_order_book& book, const ats::level2_message& msg);
+
+		// Updates the simulated queues with a delta message once the exchange book has been updated
+		void update_queues(const ats::level2_message& msg_delta);
+
 		void add_order_status_listener(const ats::order_status_handler& listener)
 		{
 			order_status_listener_ = listener;
@@ -31,10 +43,30 @@ namespace sim
 		const ats::sim::price_level* get_level(ats::price_t price, bool is_bid) const
 		{ return sim_book_.get_level(price, is_bid); }
 
-		const ats::exchange_order_book& get_order_book() const { return book_; }
+		// The books of a parameter sweep (see ats::level2_sweep) share the exchange book, which the sweep
+		// updates once per message; the book then only keeps the simulated queues
+		void set_reference_book(const ats::exchange_order_book* book) { reference_ = book; }
+
+		const ats::exchange_order_book& get_order_book() const { return reference_ != nullptr ? *reference_ : book_; }
 
 		const order_container& get_sim_orders() const { return sim_book_.get_sim_orders(); }
 
+		// Snapshot of the exchange book and the simulated queues (see book_snapshot.hpp)
+		void save(std::ostream& out) const
+		{
+			get_order_book().save(out);
+			sim_book_.save(out);
+		}
+
+		// A book sharing the exchange book of a sweep cannot be restored, as the shared book would not be
+		void load(std::istream& in)
+		{
+			if (reference_ != nullptr)
+				throw std::logic_error("fifo_exchange_order_book: Cannot load a snapshot into a book that shares its exchange book");
+			book_.load(in);
+			sim_book_.load(in, book_.symbol().to_string());
+		}
+
 //	private:
 		void process_change_msg(const ats::level2_message& msg);
 		void process_delete_msg(const ats::level2_message& msg);
@@ -42,35 +74,39 @@ namespace sim
 		void process_insert_msg(const ats::level2_message& msg) { sim_book_.process_insert_msg(msg); }
 	private:
 		ats::exchange_order_book book_;
-		ats::sim::sim_book sim_book_;
+		const ats::exchange_order_book* reference_ = nullptr;  // shared exchange book used instead of book_
+		sim_book_type sim_book_;
 		ats::order_status_handler order_status_listener_;
 	};
 
+	typedef basic_fifo_exchange_order_book<ats::sim::sim_book> fifo_exchange_order_book;
+	typedef basic_fifo_exchange_order_book<ats::sim::tick_sim_book> tick_fifo_exchange_order_book;
 
-	inline void fifo_exchange_order_book::add_order(const ats::limit_order& order)
+
+	template<typename sim_book_type>
+	inline void basic_fifo_exchange_order_book<sim_book_type>::add_order(const ats::limit_order& order)
 	{
+		const ats::exchange_order_book& book = get_order_book();
 		if (order.side() == ats::order_side::Buy || order.side() == ats::order_side::BuyCover)
 		{
-			if (book_.best_ask() != nullptr && order.price() >= book_.best_ask()->price)
+			if (book.best_ask() != nullptr && order.price() >= book.best_ask()->price)
 			{
 				ats::order_status_filled_message msg(order.id(), order.transact_time,
-						book_.best_ask()->price, order.quantity());
+						book.best_ask()->price, order.quantity());
 				order_status_listener_(msg);
 			}
 			else
 			{
-				const auto* true_l = book_.bid_at(order.price());
+				const auto* true_l = book.bid_at(order.price());
 				const ats::sim::price_level* l = sim_book_.get_level(order.price(), true);
-				if (true_l == nullptr && !book_.bids().empty() && order.price() <= book_.best_bid()->price
-						&& order.price() >= book_.bids().crbegin()->first)
+				if (true_l == nullptr && !book.bids().empty() && order.price() <= book.best_bid()->price
+						&& order.price() >= book.bids().crbegin()->first)
 					sim_book_.insert_order(order);
 				else
 				{
 					if (true_l != nullptr && (l == nullptr || !l->is_defined()))
 					{
-						ats::limit_order ord(0, order.symbol(), true_l->quantity, order.side(),
-								ats::order_time_in_force::GTC, order.price());
-						sim_book_.insert_order(ord);
+						sim_book_.insert_order(order.price(), ats::sim::resting_order(0, true_l->quantity, order.side()));
 					}
 					sim_book_.add_order(order);
 				}
@@ -78,26 +114,24 @@ namespace sim
 		}
 		else
 		{
-			if (book_.best_bid() != nullptr && order.price() <= book_.best_bid()->price)
+			if (book.best_bid() != nullptr && order.price() <= book.best_bid()->price)
 			{
 				ats::order_status_filled_message msg(order.id(), order.transact_time,
-						book_.best_bid()->price, order.quantity());
+						book.best_bid()->price, order.quantity());
 				order_status_listener_(msg);
 			}
 			else
 			{
-				const auto* true_l = book_.ask_at(order.price());
+				const auto* true_l = book.ask_at(order.price());
 				const ats::sim::price_level* l = sim_book_.get_level(order.price(), false);
-				if (true_l == nullptr && !book_.asks().empty() && order.price() >= book_.best_ask()->price
-						&& order.price() <= book_.asks().crbegin()->first)
+				if (true_l == nullptr && !book.asks().empty() && order.price() >= book.best_ask()->price
+						&& order.price() <= book.asks().crbegin()->first)
 					sim_book_.insert_order(order);
 				else
 				{
 					if (true_l != nullptr && (l == nullptr || !l->is_defined()))
 					{
-						ats::limit_order ord(0, order.symbol(), true_l->quantity, order.side(),
-								ats::order_time_in_force::GTC, order.price());
-						sim_book_.insert_order(ord);
+						sim_book_.insert_order(order.price(), ats::sim::resting_order(0, true_l->quantity, order.side()));
 					}
 					sim_book_.add_order(order);
 				}
@@ -105,24 +139,28 @@ namespace sim
 		}
 	}
 
-	inline void fifo_exchange_order_book::process_change_msg(const ats::level2_message& msg)
+	template<typename sim_book_type>
+	inline void basic_fifo_exchange_order_book<sim_book_type>::process_change_msg(const ats::level2_message& msg)
 	{
 		sim_book_.process_change_msg(msg);
 	}
 
-	inline void fifo_exchange_order_book::process_delete_msg(const ats::level2_message& msg)
+	template<typename sim_book_type>
+	inline void basic_fifo_exchange_order_book<sim_book_type>::process_delete_msg(const ats::level2_message& msg)
 	{
 		sim_book_.process_delete_msg(msg);
 	}
 
-	inline void fifo_exchange_order_book::update(const ats::level2_message& msg)
+	template<typename sim_book_type>
+	inline ats::level2_message basic_fifo_exchange_order_book<sim_book_type>::make_delta(const ats::exchange_order_book& book,
+			const ats::level2_message& msg)
 	{
 		// Create a "delta" message
 		ats::level2_message msg_delta = msg;
 		if (msg.update_action == ats::update_action::Change)
 		{
 			const ats::exchange_order_book::price_level_type* lptr = msg.entry_type == ats::entry_type::Bid ?
-					book_.bid_at(msg.price) : book_.ask_at(msg.price);
+					book.bid_at(msg.price) : book.ask_at(msg.price);
 
 			if (lptr != nullptr)
 				msg_delta.quantity = msg.quantity - lptr->quantity;
@@ -130,22 +168,34 @@ namespace sim
 		// this is not used (at least for now):
 		else if (msg.entry_type == ats::entry_type::Trade)
 		{
-			if (book_.best_ask() != nullptr && msg.price >= book_.best_ask()->price)
+			if (book.best_ask() != nullptr && msg.price >= book.best_ask()->price)
 				msg_delta.aggressor_side = 1;
-			else if (book_.best_bid() != nullptr && msg.price <= book_.best_bid()->price)
+			else if (book.best_bid() != nullptr && msg.price <= book.best_bid()->price)
 				msg_delta.aggressor_side = -1;
 			else
 				msg_delta.aggressor_side = 0;
 		}
+		return msg_delta;
+	}
 
-		book_.update(msg);
-
-		const ats::price_t* bid = book_.best_bid() == nullptr ? nullptr : &book_.best_bid()->price;
-		const ats::price_t* ask = book_.best_ask() == nullptr ? nullptr : &book_.best_ask()->price;
-		sim_book_.execute_crosses(bid, ask, msg.time);
+	template<typename sim_book_type>
+	inline void basic_fifo_exchange_order_book<sim_book_type>::update_queues(const ats::level2_message& msg_delta)
+	{
+		const ats::exchange_order_book& book = get_order_book();
+		const ats::price_t* bid = book.best_bid() == nullptr ? nullptr : &book.best_bid()->price;
+		const ats::price_t* ask = book.best_ask() == nullptr ? nullptr : &book.best_ask()->price;
+		sim_book_.execute_crosses(bid, ask, msg_delta.time);
 
 		sim_book_.process_level2_msg(msg_delta);
 	}
+
+	template<typename sim_book_type>
+	inline void basic_fifo_exchange_order_book<sim_book_type>::update(const ats::level2_message& msg)
+	{
+		ats::level2_message msg_delta = make_delta(book_, msg);
+		book_.update(msg);
+		update_queues(msg_delta);
+	}
 }
 }
 
@@ -1,22 +1,32 @@
 #ifndef SIM_BOOK_HPP
 #define SIM_BOOK_HPP
 
-#include <unordered_map>
 #include "sim_book_price_levels.hpp"
+#include "sim_book_tick_levels.hpp"
+#include <ats/container/order_index.hpp>
 #include <ats/message/order_status_message.hpp>
+#include <ats/security/metainfo.hpp>
 
 namespace ats {
 namespace sim
 {
-	class sim_book
+	// Simulated queues of a book. The sides are levels_type<std::greater> for bids and levels_type<std::less>
+	// for asks, either price_levels (a tree) or tick_price_levels (a ladder indexed by tick)
+	template<template<typename> class levels_type = price_levels>
+	class basic_sim_book
 	{
 	public:
-		typedef price_levels<std::greater<ats::price_t>> bid_container;
-		typedef price_levels<std::less<ats::price_t>> ask_container;
-		typedef std::unordered_map<ats::orderid_t, price_level::iterator> order_container;
+		typedef levels_type<std::greater<ats::price_t>> bid_container;
+		typedef levels_type<std::less<ats::price_t>> ask_container;
+		typedef price_level::order_container order_container;
 
+		explicit basic_sim_book(const ats::metainfo& info = ats::metainfo())
+			: bids_(info), asks_(info) { }
+
+		// Orders are queued as resting_order records, the orders themselves stay with the engine
 		void add_order(const ats::limit_order& order);
 		void insert_order(const ats::limit_order& order);
+		void insert_order(ats::price_t price, const ats::sim::resting_order& order);
 		void cancel_order(const ats::orderid_t& id, const ats::timestamp_t& time);
 
 		void process_trade(ats::price_t price, long quantity, const ats::timestamp_t& time);
@@ -51,6 +61,21 @@ namespace sim
 		void process_insert_msg(const ats::level2_message& msg);
 		void process_level2_msg(const ats::level2_message& msg);
 
+		// Snapshot of the levels and their queues (see book_snapshot.hpp); orders in the queues are
+		// given the symbol passed to load
+		void save(std::ostream& out) const
+		{
+			bids_.save(out);
+			asks_.save(out);
+		}
+
+		void load(std::istream& in, const std::string& symbol)
+		{
+			sim_orders_.clear();
+			bids_.load(in, symbol, sim_orders_);
+			asks_.load(in, symbol, sim_orders_);
+		}
+
 	private:
 		bid_container bids_;
 		ask_container asks_;
@@ -58,8 +83,12 @@ namespace sim
 		ats::order_status_handler order_status_listener_ = nullptr;
 	};
 
+	typedef basic_sim_book<price_levels> sim_book;
+	typedef basic_sim_book<tick_price_levels> tick_sim_book;
+
 
-	inline void sim_book::add_order(const ats::limit_order& order)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::add_order(const ats::limit_order& order)
 	{
 		// First, check for crosses, then add if there still is a quantity left
 		price_level::iterator order_pos;
@@ -92,13 +121,12 @@ namespace sim
 
 				if (unexecuted_qty > 0)
 				{
-					ats::limit_order reduced_order(order.id(), order.symbol(), unexecuted_qty, order.side(),
-							order.time_in_force(), order.price());
-					order_pos = bids_.add_order(reduced_order);
+					ats::sim::resting_order reduced_order(order.id(), unexecuted_qty, order.side());
+					order_pos = bids_.add_order(order.price(), reduced_order);
 				}
 			}
 			else
-				order_pos = bids_.add_order(order);
+				order_pos = bids_.add_order(order.price(), ats::sim::resting_order(order));
 		}
 		else
 		{
@@ -129,39 +157,46 @@ namespace sim
 
 				if (unexecuted_qty > 0)
 				{
-					ats::limit_order reduced_order(order.id(), order.symbol(), unexecuted_qty, order.side(),
-							order.time_in_force(), order.price());
-					order_pos = asks_.add_order(reduced_order);
+					ats::sim::resting_order reduced_order(order.id(), unexecuted_qty, order.side());
+					order_pos = asks_.add_order(order.price(), reduced_order);
 				}
 			}
 			else
-				order_pos = asks_.add_order(order);
+				order_pos = asks_.add_order(order.price(), ats::sim::resting_order(order));
 		}
 
 		// For bookkeeping
 		if (order.id() != 0)
-			sim_orders_.insert(std::make_pair(order.id(), order_pos));
+			sim_orders_.insert(std::make_pair(order.id(), price_level::order_handle{ order_pos, order.price() }));
+	}
+
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::insert_order(const ats::limit_order& order)
+	{
+		insert_order(order.price(), ats::sim::resting_order(order));
 	}
 
-	inline void sim_book::insert_order(const ats::limit_order& order)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::insert_order(ats::price_t price, const ats::sim::resting_order& order)
 	{
 		price_level::iterator order_pos;
 		if (order.side() == ats::order_side::Buy || order.side() == ats::order_side::BuyCover)
-			order_pos = bids_.insert_order(order);
+			order_pos = bids_.insert_order(price, order);
 		else
-			order_pos = asks_.insert_order(order);
+			order_pos = asks_.insert_order(price, order);
 
-		if (order.id() != 0)
-			sim_orders_.insert(std::make_pair(order.id(), order_pos));
+		if (order.is_own())
+			sim_orders_.insert(std::make_pair(order.id(), price_level::order_handle{ order_pos, price }));
 	}
 
-	inline void sim_book::cancel_order(const ats::orderid_t& id, const ats::timestamp_t& time)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::cancel_order(const ats::orderid_t& id, const ats::timestamp_t& time)
 	{
 		auto find = sim_orders_.find(id);
 		if (find == sim_orders_.end()) return;
 
 		auto pos = find->second;
-		if (pos->side() == ats::order_side::Buy || pos->side() == ats::order_side::BuyCover)
+		if (pos.position->side() == ats::order_side::Buy || pos.position->side() == ats::order_side::BuyCover)
 			bids_.cancel_order(pos, time);
 		else
 			asks_.cancel_order(pos, time);
@@ -172,7 +207,8 @@ namespace sim
 			order_status_listener_(ats::order_status_cancelled_message(id, time, "Canceled by trader"));
 	}
 
-	inline void sim_book::process_trade(price_t price, long quantity, const ats::timestamp_t& time)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::process_trade(price_t price, long quantity, const ats::timestamp_t& time)
 	{
 		// Check for crosses
 		while (best_bid() != nullptr && price < best_bid()->price())
@@ -191,7 +227,8 @@ namespace sim
 		}
 	}
 
-	inline void sim_book::clean_level(ats::price_t price, bool is_bid)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::clean_level(ats::price_t price, bool is_bid)
 	{
 		if (is_bid)
 			bids_.clean(price);
@@ -199,7 +236,8 @@ namespace sim
 			asks_.clean(price);
 	}
 
-	inline void sim_book::execute_all_orders(ats::price_t price, const ats::timestamp_t& time, bool is_bid)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::execute_all_orders(ats::price_t price, const ats::timestamp_t& time, bool is_bid)
 	{
 		if (is_bid)
 			bids_.execute_all_orders(price, time, sim_orders_);
@@ -207,7 +245,8 @@ namespace sim
 			asks_.execute_all_orders(price, time, sim_orders_);
 	}
 
-	inline void sim_book::execute_orders(ats::price_t price, long quantity, const ats::timestamp_t& time, bool is_bid)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::execute_orders(ats::price_t price, long quantity, const ats::timestamp_t& time, bool is_bid)
 	{
 		if (is_bid)
 			bids_.execute_orders(price, quantity, time, sim_orders_);
@@ -215,7 +254,8 @@ namespace sim
 			asks_.execute_orders(price, quantity, time, sim_orders_);
 	}
 
-	inline void sim_book::execute_crosses(const ats::price_t* bid, const ats::price_t* ask, const ats::timestamp_t& time)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::execute_crosses(const ats::price_t* bid, const ats::price_t* ask, const ats::timestamp_t& time)
 	{
 		if (bid != nullptr)
 		{
@@ -231,7 +271,8 @@ namespace sim
 	}
 
 
-	inline void sim_book::process_change_msg(const ats::level2_message& msg)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::process_change_msg(const ats::level2_message& msg)
 	{
 		if (msg.entry_type == ats::entry_type::Bid)
 		{
@@ -249,7 +290,8 @@ namespace sim
 		}
 	}
 
-	inline void sim_book::process_delete_msg(const ats::level2_message& msg)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::process_delete_msg(const ats::level2_message& msg)
 	{
 		if (msg.entry_type == ats::entry_type::Bid)
 			bids_.process_delete_msg(msg, sim_orders_);
@@ -257,7 +299,8 @@ namespace sim
 			asks_.process_delete_msg(msg, sim_orders_);
 	}
 
-	inline void sim_book::process_trade_msg(const ats::level2_message& msg)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::process_trade_msg(const ats::level2_message& msg)
 	{
 		process_trade(msg.price, msg.quantity, msg.time);
 
@@ -267,7 +310,8 @@ namespace sim
 			best_ask()->traded_quantity = msg.quantity;
 	}
 
-	inline void sim_book::process_insert_msg(const ats::level2_message& msg)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::process_insert_msg(const ats::level2_message& msg)
 	{
 		if (msg.entry_type == ats::entry_type::Bid)
 			bids_.process_insert_msg(msg);
@@ -275,7 +319,8 @@ namespace sim
 			asks_.process_insert_msg(msg);
 	}
 
-	inline void sim_book::process_level2_msg(const ats::level2_message& msg)
+	template<template<typename> class levels_type>
+	inline void basic_sim_book<levels_type>::process_level2_msg(const ats::level2_message& msg)
 	{
 		if (msg.entry_type == ats::entry_type::Trade)
 			process_trade_msg(msg);
@@ -0,0 +1,251 @@
+#ifndef SIM_BOOK_ORDER_QUEUE_HPP
+#define SIM_BOOK_ORDER_QUEUE_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ats
+{
+	namespace sim
+	{
+		namespace queue_detail
+		{
+			struct link
+			{
+				link* prev;
+				link* next;
+			};
+
+			template<typename T>
+			struct node : link
+			{
+				typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+				T& value() { return *std::launder(reinterpret_cast<T*>(&storage)); }
+			};
+		}
+
+		// Slab of the nodes of the queues of a book side (see order_queue). Nodes are carved from chunks
+		// that grow geometrically and are recycled through a free list, so that once the book has warmed
+		// up queue entries are created without allocating. The pool must outlive its queues
+		template<typename T>
+		class order_queue_pool
+		{
+		public:
+			typedef queue_detail::node<T> node_type;
+
+			order_queue_pool() = default;
+			order_queue_pool(const order_queue_pool&) = delete;
+			order_queue_pool& operator=(const order_queue_pool&) = delete;
+
+			node_type* create(const T& value)
+			{
+				if (free_ == nullptr)
+					grow();
+
+				node_type* n = free_;
+				::new (static_cast<void*>(&n->storage)) T(value);
+				free_ = static_cast<node_type*>(n->next);
+				return n;
+			}
+
+			void destroy(node_type* n)
+			{
+				n->value().~T();
+				n->next = free_;
+				free_ = n;
+			}
+
+		private:
+			static constexpr size_t max_chunk_size = 4096U;
+
+			void grow()
+			{
+				chunks_.emplace_back(new node_type[chunk_size_]);
+				node_type* chunk = chunks_.back().get();
+				for (size_t k = chunk_size_; k > 0; --k)
+				{
+					chunk[k - 1].next = free_;
+					free_ = &chunk[k - 1];
+				}
+				if (chunk_size_ < max_chunk_size)
+					chunk_size_ *= 2;
+			}
+
+		private:
+			std::vector<std::unique_ptr<node_type[]>> chunks_;
+			node_type* free_ = nullptr;
+			size_t chunk_size_ = 64U;
+		};
+
+		// FIFO queue of a price level: an intrusive doubly-linked list of nodes taken from a pool. As with
+		// std::list, iterators stay valid until their entry is erased, also when the queue is moved, so that
+		// they serve as handles of simulated orders. Copies take their nodes from the same pool
+		template<typename T>
+		class order_queue
+		{
+			typedef queue_detail::link link;
+			typedef queue_detail::node<T> node;
+		public:
+			typedef order_queue_pool<T> pool_type;
+
+			template<bool is_const>
+			class basic_iterator
+			{
+				friend class order_queue;
+			public:
+				typedef std::bidirectional_iterator_tag iterator_category;
+				typedef T value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef typename std::conditional<is_const, const T*, T*>::type pointer;
+				typedef typename std::conditional<is_const, const T&, T&>::type reference;
+
+				basic_iterator() = default;
+
+				// An iterator converts to a const_iterator
+				template<bool other_const, typename = typename std::enable_if<is_const && !other_const>::type>
+				basic_iterator(const basic_iterator<other_const>& other) : link_(other.link_) { }
+
+				reference operator*() const { return static_cast<node*>(link_)->value(); }
+				pointer operator->() const { return &static_cast<node*>(link_)->value(); }
+
+				basic_iterator& operator++() { link_ = link_->next; return *this; }
+				basic_iterator operator++(int) { basic_iterator it = *this; link_ = link_->next; return it; }
+				basic_iterator& operator--() { link_ = link_->prev; return *this; }
+				basic_iterator operator--(int) { basic_iterator it = *this; link_ = link_->prev; return it; }
+
+				bool operator==(const basic_iterator& other) const { return link_ == other.link_; }
+				bool operator!=(const basic_iterator& other) const { return link_ != other.link_; }
+
+			private:
+				template<bool> friend class basic_iterator;
+
+				explicit basic_iterator(link* l) : link_(l) { }
+
+				link* link_ = nullptr;
+			};
+
+			typedef basic_iterator<false> iterator;
+			typedef basic_iterator<true> const_iterator;
+			typedef std::reverse_iterator<iterator> reverse_iterator;
+			typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+			explicit order_queue(pool_type* pool = nullptr) : pool_(pool) { reset(); }
+
+			order_queue(const order_queue& other) : pool_(other.pool_)
+			{
+				reset();
+				for (const auto& value : other)
+					push_back(value);
+			}
+
+			order_queue(order_queue&& other) noexcept : pool_(other.pool_) { take(other); }
+
+			order_queue& operator=(const order_queue& other)
+			{
+				if (this != &other)
+				{
+					clear();
+					pool_ = other.pool_;
+					for (const auto& value : other)
+						push_back(value);
+				}
+				return *this;
+			}
+
+			order_queue& operator=(order_queue&& other) noexcept
+			{
+				if (this != &other)
+				{
+					clear();
+					pool_ = other.pool_;
+					take(other);
+				}
+				return *this;
+			}
+
+			~order_queue() { clear(); }
+
+			iterator begin() { return iterator(head_.next); }
+			iterator end() { return iterator(&head_); }
+			const_iterator begin() const { return const_iterator(head_.next); }
+			const_iterator end() const { return const_iterator(const_cast<link*>(&head_)); }
+			reverse_iterator rbegin() { return reverse_iterator(end()); }
+			reverse_iterator rend() { return reverse_iterator(begin()); }
+
+			bool empty() const { return size_ == 0; }
+			size_t size() const { return size_; }
+
+			iterator push_back(const T& value) { return iterator(link_before(&head_, pool_->create(value))); }
+			iterator push_front(const T& value) { return iterator(link_before(head_.next, pool_->create(value))); }
+
+			// Erases an entry, returning the next one
+			iterator erase(iterator position)
+			{
+				link* l = position.link_;
+				link* next = l->next;
+				l->prev->next = next;
+				next->prev = l->prev;
+				pool_->destroy(static_cast<node*>(l));
+				--size_;
+				return iterator(next);
+			}
+
+			void clear()
+			{
+				for (link* l = head_.next; l != &head_;)
+				{
+					link* next = l->next;
+					pool_->destroy(static_cast<node*>(l));
+					l = next;
+				}
+				reset();
+			}
+
+		private:
+			void reset()
+			{
+				head_.prev = head_.next = &head_;
+				size_ = 0;
+			}
+
+			link* link_before(link* position, link* l)
+			{
+				l->prev = position->prev;
+				l->next = position;
+				position->prev->next = l;
+				position->prev = l;
+				++size_;
+				return l;
+			}
+
+			// Takes the entries of another queue, whose sentinel is relinked to this one
+			void take(order_queue& other)
+			{
+				if (other.empty())
+				{
+					reset();
+					return;
+				}
+
+				head_ = other.head_;
+				head_.next->prev = &head_;
+				head_.prev->next = &head_;
+				size_ = other.size_;
+				other.reset();
+			}
+
+		private:
+			pool_type* pool_;
+			link head_;     // sentinel of the circular list
+			size_t size_;
+		};
+	}
+}
+
+#endif
\ No newline at end of file
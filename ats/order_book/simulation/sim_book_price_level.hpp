@@ -1,26 +1,69 @@
 #ifndef SIM_BOOK_PRICE_LEVEL_HPP
 #define SIM_BOOK_PRICE_LEVEL_HPP
 
-#include <list>
-#include <unordered_map>
+#include <cstdint>
 #include <string>
 #include <sstream>
+#include <type_traits>
+#include <ats/container/order_index.hpp>
 #include <ats/order/limit_order.hpp>
 #include <ats/message/level2_message.hpp>
 #include <ats/handler_types.hpp>
+#include <ats/io/format/book_snapshot.hpp>
+#include "sim_book_order_queue.hpp"
 
 namespace ats
 {
 	namespace sim
 	{
+		// Entry of a simulated queue: an order of the strategy, or quantity of other traders (id 0) around
+		// it. Only what the queue needs is kept; the full orders live in the order table of the engine
+		class resting_order
+		{
+		public:
+			resting_order() = default;
+
+			resting_order(ats::orderid_t id, long quantity, ats::order_side side)
+				: id_(id), quantity_(static_cast<int32_t>(quantity)), side_(static_cast<uint8_t>(side)), is_own_(id != 0) { }
+
+			explicit resting_order(const ats::order& order)
+				: resting_order(order.id(), order.quantity(), order.side()) { }
+
+			ats::orderid_t id() const { return id_; }
+			long quantity() const { return quantity_; }
+			ats::order_side side() const { return static_cast<ats::order_side>(side_); }
+			bool is_own() const { return is_own_; }  // an order of the strategy
+
+			void set_quantity(long new_quantity) { quantity_ = static_cast<int32_t>(new_quantity); }
+
+		private:
+			ats::orderid_t id_ = 0;
+			int32_t quantity_ = 0;
+			uint8_t side_ = 0;
+			bool is_own_ = false;
+		};
+
+		static_assert(std::is_trivially_copyable<resting_order>::value && sizeof(resting_order) == 16,
+			"resting_order must be a 16-byte trivially copyable record");
+
 		class price_level
 		{
 		public:
-			typedef std::list<ats::limit_order> orderqueue_type;
+			typedef ats::sim::order_queue<ats::sim::resting_order> orderqueue_type;
+			typedef orderqueue_type::pool_type pool_type;
 			typedef orderqueue_type::iterator iterator;
-			typedef std::unordered_map<ats::orderid_t, iterator> order_container;
 
-			price_level(ats::price_t price) : price_(price) { }
+			// Position of an order of the strategy in the queues of a book
+			struct order_handle
+			{
+				iterator position;
+				ats::price_t price;
+			};
+
+			typedef ats::order_index<order_handle> order_container;
+
+			// The queue takes its entries from the pool of the book side; a level without a pool stays empty
+			price_level(ats::price_t price, pool_type* pool = nullptr) : price_(price), queue_(pool) { }
 
 			iterator begin() { return queue_.begin(); }
 			iterator end() { return queue_.end(); }
@@ -28,8 +71,8 @@ namespace ats
 			ats::price_t price() const { return price_; }
 			bool is_defined() const { return is_defined_; }
 
-			iterator add_order(const ats::limit_order& order);
-			iterator insert_order(const ats::limit_order& order);
+			iterator add_order(const ats::sim::resting_order& order);
+			iterator insert_order(const ats::sim::resting_order& order);
 			bool erase_order(iterator position);
 
 			// Remove orders that are not mine
@@ -42,6 +85,10 @@ namespace ats
 
 			std::string to_string() const;
 
+			// Snapshot of the level with its queue (see book_snapshot.hpp)
+			void save(std::ostream& out) const;
+			void load(std::istream& in, const std::string& symbol);
+
 			void process_change_msg(const ats::level2_message& msg, ats::order_status_handler& listener,
 				order_container& orders);
 
@@ -55,24 +102,24 @@ namespace ats
 			bool is_defined_ = false;
 		};
 
-		inline price_level::iterator price_level::add_order(const ats::limit_order& order)
+		inline price_level::iterator price_level::add_order(const ats::sim::resting_order& order)
 		{
-			queue_.push_back(order);
-			if (order.id() != 0)
+			iterator it = queue_.push_back(order);
+			if (order.is_own())
 				sim_quantity += order.quantity();
 			quantity += order.quantity();
 
-			return std::prev(queue_.end());
+			return it;
 		}
 
-		inline price_level::iterator price_level::insert_order(const ats::limit_order& order)
+		inline price_level::iterator price_level::insert_order(const ats::sim::resting_order& order)
 		{
-			queue_.push_front(order);
-			if (order.id() != 0)
+			iterator it = queue_.push_front(order);
+			if (order.is_own())
 				sim_quantity += order.quantity();
 			quantity += order.quantity();
 			is_defined_ = true;
-			return queue_.begin();
+			return it;
 		}
 
 		inline bool price_level::erase_order(iterator position)
@@ -80,7 +127,7 @@ namespace ats
 			if (position != queue_.end())
 			{
 				quantity -= position->quantity();
-				if (position->id() != 0)
+				if (position->is_own())
 					sim_quantity -= position->quantity();
 				queue_.erase(position);
 				return true;
@@ -93,7 +140,7 @@ namespace ats
 		{
 			for (auto it = queue_.begin(); it != queue_.end();)
 			{
-				if (it->id() == 0)
+				if (!it->is_own())
 					queue_.erase(it++);
 				else
 					++it;
@@ -107,7 +154,7 @@ namespace ats
 			long remained_qty = qty;
 			for (auto it = queue_.rbegin(); it != queue_.rend() && remained_qty > 0;)
 			{
-				if (it->id() != 0)
+				if (it->is_own())
 					++it;
 				else if (it->quantity() > remained_qty)
 				{
@@ -119,9 +166,9 @@ namespace ats
 				{
 					quantity -= it->quantity();
 					remained_qty -= it->quantity();
+					// The reverse iterator made from the entry after the erased one points to the entry before it
 					auto rm = --it.base();
-					++it;
-					queue_.erase(rm);
+					it = decltype(it)(queue_.erase(rm));
 				}
 			}
 		}
@@ -131,7 +178,7 @@ namespace ats
 		{
 			for (auto it = queue_.begin(); it != queue_.end();)
 			{
-				if (it->id() != 0)
+				if (it->is_own())
 				{
 					auto ord_it = orders.find(it->id());
 					if (ord_it != orders.end())
@@ -157,10 +204,10 @@ namespace ats
 				{
 					it->set_quantity(it->quantity() - unexecuted_qty);
 					quantity -= unexecuted_qty;
-					if (it->id() != 0)
+					if (it->is_own())
 					{
 						sim_quantity -= unexecuted_qty;
-						ats::order_status_partially_filled_message msg(it->id(), time, it->price(), unexecuted_qty);
+						ats::order_status_partially_filled_message msg(it->id(), time, price_, unexecuted_qty);
 						listener(msg);
 					}
 					break;
@@ -168,14 +215,14 @@ namespace ats
 				else
 				{
 					quantity -= it->quantity();
-					if (it->id() != 0)
+					if (it->is_own())
 					{
 						auto ord_it = orders.find(it->id());
 						if (ord_it != orders.end())
 							orders.erase(ord_it);
 
 						sim_quantity -= it->quantity();
-						ats::order_status_filled_message msg(it->id(), time, it->price(), it->quantity());
+						ats::order_status_filled_message msg(it->id(), time, price_, it->quantity());
 						listener(msg);
 					}
 					unexecuted_qty -= it->quantity();
@@ -195,6 +242,36 @@ namespace ats
 			return ss.str();
 		}
 
+		inline void price_level::save(std::ostream& out) const
+		{
+			ats::book_snapshot::write(out, static_cast<int32_t>(price_));
+			ats::book_snapshot::write(out, static_cast<int64_t>(quantity));
+			ats::book_snapshot::write(out, static_cast<int64_t>(sim_quantity));
+			ats::book_snapshot::write(out, static_cast<int64_t>(traded_quantity));
+			ats::book_snapshot::write(out, static_cast<uint8_t>(is_defined_));
+			ats::book_snapshot::write(out, static_cast<uint64_t>(queue_.size()));
+			// Entries are written as orders at the price of the level, so that the format does not change.
+			// Records have no time, which is left undefined
+			for (const auto& entry : queue_)
+			{
+				ats::book_snapshot::write_order(out, ats::limit_order(entry.id(), ats::name_registry::npos,
+					entry.quantity(), entry.side(), ats::order_time_in_force::GTC, price_));
+			}
+		}
+
+		inline void price_level::load(std::istream& in, const std::string& symbol)
+		{
+			price_ = ats::book_snapshot::read<int32_t>(in);
+			quantity = ats::book_snapshot::read<int64_t>(in);
+			sim_quantity = ats::book_snapshot::read<int64_t>(in);
+			traded_quantity = ats::book_snapshot::read<int64_t>(in);
+			is_defined_ = ats::book_snapshot::read<uint8_t>(in) != 0;
+
+			queue_.clear();
+			for (uint64_t n = ats::book_snapshot::read<uint64_t>(in); n > 0; --n)
+				queue_.push_back(ats::sim::resting_order(ats::book_snapshot::read_order<ats::limit_order>(in, symbol)));
+		}
+
 		inline void price_level::process_change_msg(const ats::level2_message& msg, ats::order_status_handler& listener,
 			order_container& orders)
 		{
@@ -202,7 +279,7 @@ namespace ats
 			{
 				ats::order_side side = msg.entry_type == ats::entry_type::Bid ?
 					ats::order_side::Buy : ats::order_side::SellShort;
-				ats::limit_order order(0, msg.symbol, msg.quantity, side, ats::order_time_in_force::GTC, msg.price);
+				ats::sim::resting_order order(0, msg.quantity, side);
 
 				if (!is_defined_)
 					insert_order(order);
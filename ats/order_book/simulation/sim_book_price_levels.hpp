@@ -2,7 +2,9 @@
 #define SIM_BOOK_PRICE_LEVELS_HPP
 
 #include <map>
+#include <memory>
 #include "sim_book_price_level.hpp"
+#include <ats/security/metainfo.hpp>
 
 namespace ats
 {
@@ -11,20 +13,28 @@ namespace ats
 		template<typename comp = std::less<ats::price_t>>
 		class price_levels
 		{
-			typedef std::unordered_map<ats::orderid_t, price_level::iterator> order_container;
+			typedef price_level::order_container order_container;
 		public:
 			typedef typename std::map<ats::price_t, ats::sim::price_level, comp> container_type;
 			typedef typename container_type::iterator iterator;
 
+			price_levels() = default;
+
+			// The tree takes any price, so it does not need the tick size (cf. tick_price_levels)
+			explicit price_levels(const ats::metainfo& /*info*/) { }
+
+			price_levels(price_levels&&) = default;
+			price_levels& operator=(price_levels&&) = delete;  // the queues would outlive their pool
+
 			void add_order_status_listener(const ats::order_status_handler& listener)
 			{
 				order_status_listener_ = listener;
 			}
 
-			price_level::iterator add_order(const ats::limit_order& order);
-			price_level::iterator insert_order(const ats::limit_order& order);
-			void cancel_order(price_level::iterator position, const ats::timestamp_t& time);
-			bool erase_order(price_level::iterator position);
+			price_level::iterator add_order(ats::price_t price, const ats::sim::resting_order& order);
+			price_level::iterator insert_order(ats::price_t price, const ats::sim::resting_order& order);
+			void cancel_order(const price_level::order_handle& handle, const ats::timestamp_t& /*time*/);
+			bool erase_order(const price_level::order_handle& handle);
 			void erase_level(ats::price_t price);
 
 			const price_level* top_level() const
@@ -55,59 +65,61 @@ namespace ats
 			void process_delete_msg(const ats::level2_message& msg, order_container& orders);
 			void process_insert_msg(const ats::level2_message& msg);
 
+			// Snapshot of the levels (see book_snapshot.hpp). Loading registers the restored orders
+			// that are not synthetic in orders
+			void save(std::ostream& out) const;
+			void load(std::istream& in, const std::string& symbol, order_container& orders);
+
 		private:
+			std::unique_ptr<price_level::pool_type> pool_ = std::make_unique<price_level::pool_type>();  // before the levels
 			container_type levels_;
 			ats::order_status_handler order_status_listener_;
 		};
 
 		template<typename comp>
-		price_level::iterator price_levels<comp>::add_order(const ats::limit_order& order)
+		price_level::iterator price_levels<comp>::add_order(ats::price_t price, const ats::sim::resting_order& order)
 		{
-			auto it = levels_.find(order.price());
+			auto it = levels_.find(price);
 			if (it != levels_.end())
 				return it->second.add_order(order);
 			else
 			{
-				price_level l(order.price());
-				l.add_order(order);
-				auto ins = levels_.insert(std::make_pair(order.price(), l)).first;
-				return std::prev(ins->second.end());
+				auto ins = levels_.emplace(price, price_level(price, pool_.get())).first;
+				return ins->second.add_order(order);
 			}
 		}
 
 		template<typename comp>
-		price_level::iterator price_levels<comp>::insert_order(const ats::limit_order& order)
+		price_level::iterator price_levels<comp>::insert_order(ats::price_t price, const ats::sim::resting_order& order)
 		{
-			auto it = levels_.find(order.price());
+			auto it = levels_.find(price);
 			if (it != levels_.end())
 				return it->second.insert_order(order);
 			else
 			{
-				price_level l(order.price());
-				l.insert_order(order);
-				auto inserted = levels_.insert(std::make_pair(order.price(), l)).first;
-				return inserted->second.begin();
+				auto inserted = levels_.emplace(price, price_level(price, pool_.get())).first;
+				return inserted->second.insert_order(order);
 			}
 		}
 
 		template<typename comp>
-		void price_levels<comp>::cancel_order(price_level::iterator position, const ats::timestamp_t& time)
+		void price_levels<comp>::cancel_order(const price_level::order_handle& handle, const ats::timestamp_t& /*time*/)
 		{
-			auto it = levels_.find(position->price());
+			auto it = levels_.find(handle.price);
 			if (it != levels_.end())
 			{
-				it->second.erase_order(position);
+				it->second.erase_order(handle.position);
 				if (it->second.sim_quantity == 0)
 					levels_.erase(it);
 			}
 		}
 
 		template<typename comp>
-		bool price_levels<comp>::erase_order(price_level::iterator position)
+		bool price_levels<comp>::erase_order(const price_level::order_handle& handle)
 		{
-			auto it = levels_.find(position->price());
+			auto it = levels_.find(handle.price);
 			if (it != levels_.end())
-				return it->second.erase_order(position);
+				return it->second.erase_order(handle.position);
 			else
 				return false;
 		}
@@ -180,6 +192,31 @@ namespace ats
 			}
 		}
 
+		template<typename comp>
+		void price_levels<comp>::save(std::ostream& out) const
+		{
+			ats::book_snapshot::write(out, static_cast<uint64_t>(levels_.size()));
+			for (const auto& level : levels_)
+				level.second.save(out);
+		}
+
+		template<typename comp>
+		void price_levels<comp>::load(std::istream& in, const std::string& symbol, order_container& orders)
+		{
+			levels_.clear();
+			for (uint64_t n = ats::book_snapshot::read<uint64_t>(in); n > 0; --n)
+			{
+				price_level level(0, pool_.get());
+				level.load(in, symbol);
+				auto it = levels_.emplace_hint(levels_.end(), level.price(), std::move(level));
+				for (auto order = it->second.begin(); order != it->second.end(); ++order)
+				{
+					if (order->is_own())
+						orders[order->id()] = price_level::order_handle{ order, it->second.price() };
+				}
+			}
+		}
+
 		template<typename comp>
 		void price_levels<comp>::process_insert_msg(const ats::level2_message& msg)
 		{
@@ -191,8 +228,7 @@ namespace ats
 					ats::order_side::Buy : ats::order_side::SellShort;
 				if (!level.is_defined())
 				{
-					ats::limit_order order(0, msg.symbol, msg.quantity, side,
-						ats::order_time_in_force::GTC, msg.price);
+					ats::sim::resting_order order(0, msg.quantity, side);
 					level.insert_order(order);
 				}
 				else
@@ -200,8 +236,7 @@ namespace ats
 					long delta = level.quantity - level.sim_quantity;
 					if (msg.quantity > delta)
 					{
-						ats::limit_order order(0, msg.symbol, msg.quantity - delta, side,
-							ats::order_time_in_force::GTC, msg.price);
+						ats::sim::resting_order order(0, msg.quantity - delta, side);
 						level.add_order(order);
 					}
 					else if (msg.quantity < delta)
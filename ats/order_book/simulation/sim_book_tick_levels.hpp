@@ -0,0 +1,385 @@
+#ifndef SIM_BOOK_TICK_LEVELS_HPP
+#define SIM_BOOK_TICK_LEVELS_HPP
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "sim_book_price_level.hpp"
+#include <ats/security/metainfo.hpp>
+
+namespace ats
+{
+	namespace sim
+	{
+		// Side of a simulated book (see price_levels) stored as a contiguous ladder of slots, one per tick:
+		// the level at a price is in the slot (price - base) / tick_size, so that finding a level takes no
+		// search. The best level is cached and, once it goes, the next one is found by walking the ladder
+		// away from the market. The ladder is recentred around the levels, and grown if they do not fit,
+		// when a level falls outside of it, up to max_size slots: levels spanning more ticks than that (e.g.,
+		// an order placed far from the market) throw std::length_error. Prices must be on the tick grid of
+		// the first level
+		template<typename comp = std::less<ats::price_t>>
+		class tick_price_levels
+		{
+			typedef price_level::order_container order_container;
+		public:
+			explicit tick_price_levels(const ats::metainfo& info = ats::metainfo(), size_t size = 256U)
+				: tick_size_(info.tick_size), slots_(std::min(std::max<size_t>(size, 1U), max_size), price_level(0)),
+				  used_(slots_.size(), 0)
+			{
+				if (tick_size_ <= 0)
+					throw std::invalid_argument("tick_price_levels: Tick size must be positive");
+			}
+
+			tick_price_levels(tick_price_levels&&) = default;
+			tick_price_levels& operator=(tick_price_levels&&) = delete;  // the queues would outlive their pool
+
+			void add_order_status_listener(const ats::order_status_handler& listener)
+			{
+				order_status_listener_ = listener;
+			}
+
+			price_level::iterator add_order(ats::price_t price, const ats::sim::resting_order& order);
+			price_level::iterator insert_order(ats::price_t price, const ats::sim::resting_order& order);
+			void cancel_order(const price_level::order_handle& handle, const ats::timestamp_t& /*time*/);
+			bool erase_order(const price_level::order_handle& handle);
+			void erase_level(ats::price_t price);
+
+			const price_level* top_level() const
+			{
+				return best_ == npos ? nullptr : &slots_[best_];
+			}
+
+			price_level* top_level()
+			{
+				return best_ == npos ? nullptr : &slots_[best_];
+			}
+
+			const price_level* get_level(ats::price_t price) const
+			{
+				size_t index = find(price);
+				return index == npos ? nullptr : &slots_[index];
+			}
+
+			bool empty() const { return count_ == 0; }
+
+			void clean(ats::price_t price);
+			void execute_all_orders(ats::price_t price, const ats::timestamp_t& time, order_container& orders);
+			void execute_orders(ats::price_t price, long quantity, const ats::timestamp_t& time, order_container& orders);
+
+			void process_change_msg(const ats::level2_message& msg, order_container& orders);
+			void process_delete_msg(const ats::level2_message& msg, order_container& orders);
+			void process_insert_msg(const ats::level2_message& msg);
+
+			// Snapshot of the levels, in the format of price_levels
+			void save(std::ostream& out) const;
+			void load(std::istream& in, const std::string& symbol, order_container& orders);
+
+		private:
+			static constexpr size_t npos = static_cast<size_t>(-1);
+			static constexpr size_t max_size = 1U << 18;  // slots of a ladder, about 20 MB
+
+			// The best level has the lowest index on the ask side and the highest on the bid side
+			static constexpr bool ascending = comp()(0, 1);
+
+			bool is_better(size_t lhs, size_t rhs) const { return ascending ? lhs < rhs : lhs > rhs; }
+
+			// Slot of the level at a price, npos if there is no such level
+			size_t find(ats::price_t price) const
+			{
+				int64_t offset = static_cast<int64_t>(price) - base_;
+				if (count_ == 0 || offset < 0 || offset % tick_size_ != 0)
+					return npos;
+				size_t index = static_cast<size_t>(offset / tick_size_);
+				return index < slots_.size() && used_[index] != 0 ? index : npos;
+			}
+
+			// Slot of the level at a price, adding an empty level if there is none
+			size_t find_or_add(ats::price_t price);
+			void erase(size_t index);
+			void recentre(ats::price_t price);
+			void clear();
+
+		private:
+			std::unique_ptr<price_level::pool_type> pool_ = std::make_unique<price_level::pool_type>();  // before the slots
+			int64_t tick_size_;
+			int64_t base_ = 0;            // price of the first slot
+			std::vector<price_level> slots_;
+			std::vector<uint8_t> used_;   // whether a slot holds a level
+			size_t count_ = 0;            // number of levels
+			size_t best_ = npos;          // slot of the best level
+			ats::order_status_handler order_status_listener_;
+		};
+
+		template<typename comp>
+		size_t tick_price_levels<comp>::find_or_add(ats::price_t price)
+		{
+			size_t index = find(price);
+			if (index != npos)
+				return index;
+
+			int64_t offset = static_cast<int64_t>(price) - base_;
+			if (count_ != 0 && offset % tick_size_ != 0)
+				throw std::invalid_argument("tick_price_levels: Price " + std::to_string(price) +
+					" is not on the tick grid");
+			if (count_ == 0 || offset < 0 || offset / tick_size_ >= static_cast<int64_t>(slots_.size()))
+			{
+				recentre(price);
+				offset = static_cast<int64_t>(price) - base_;
+			}
+
+			index = static_cast<size_t>(offset / tick_size_);
+			slots_[index] = price_level(price, pool_.get());
+			used_[index] = 1;
+			++count_;
+			if (best_ == npos || is_better(index, best_))
+				best_ = index;
+			return index;
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::erase(size_t index)
+		{
+			slots_[index] = price_level(0);
+			used_[index] = 0;
+			if (--count_ == 0)
+				best_ = npos;
+			else if (index == best_)
+			{
+				// The next best level is further from the market
+				do
+					best_ = ascending ? best_ + 1 : best_ - 1;
+				while (used_[best_] == 0);
+			}
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::recentre(ats::price_t price)
+		{
+			size_t size = slots_.size();
+			if (count_ == 0)
+			{
+				// Nothing to move, the grid starts over at the price
+				base_ = static_cast<int64_t>(price) - static_cast<int64_t>(size / 2) * tick_size_;
+				return;
+			}
+
+			size_t first = 0, last = size - 1;
+			while (used_[first] == 0) ++first;
+			while (used_[last] == 0) --last;
+
+			int64_t low = std::min(base_ + static_cast<int64_t>(first) * tick_size_, static_cast<int64_t>(price));
+			int64_t high = std::max(base_ + static_cast<int64_t>(last) * tick_size_, static_cast<int64_t>(price));
+			size_t span = static_cast<size_t>((high - low) / tick_size_) + 1;
+			if (span > max_size)
+			{
+				throw std::length_error("tick_price_levels: Price " + std::to_string(price) + " is " +
+					std::to_string(span - 1) + " ticks from the other levels, more than the " +
+					std::to_string(max_size) + " slots of a ladder");
+			}
+			if (2 * span > size)
+				size = std::min(2 * span, max_size);
+
+			// The price is on the grid, so is the new base
+			int64_t base = low - static_cast<int64_t>((size - span) / 2) * tick_size_;
+			std::ptrdiff_t shift = static_cast<std::ptrdiff_t>((base_ - base) / tick_size_);  // new slot - old slot
+
+			// Moving the levels keeps iterators to their queues valid
+			std::vector<price_level> slots(size, price_level(0));
+			std::vector<uint8_t> used(size, 0);
+			for (size_t k = first; k <= last; ++k)
+			{
+				if (used_[k] != 0)
+				{
+					slots[k + shift] = std::move(slots_[k]);
+					used[k + shift] = 1;
+				}
+			}
+
+			slots_.swap(slots);
+			used_.swap(used);
+			base_ = base;
+			best_ += shift;
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::clear()
+		{
+			for (size_t k = 0; k < slots_.size(); ++k)
+			{
+				if (used_[k] != 0)
+				{
+					slots_[k] = price_level(0);
+					used_[k] = 0;
+				}
+			}
+			count_ = 0;
+			best_ = npos;
+		}
+
+		template<typename comp>
+		price_level::iterator tick_price_levels<comp>::add_order(ats::price_t price, const ats::sim::resting_order& order)
+		{
+			return slots_[find_or_add(price)].add_order(order);
+		}
+
+		template<typename comp>
+		price_level::iterator tick_price_levels<comp>::insert_order(ats::price_t price, const ats::sim::resting_order& order)
+		{
+			return slots_[find_or_add(price)].insert_order(order);
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::cancel_order(const price_level::order_handle& handle, const ats::timestamp_t& /*time*/)
+		{
+			size_t index = find(handle.price);
+			if (index != npos)
+			{
+				slots_[index].erase_order(handle.position);
+				if (slots_[index].sim_quantity == 0)
+					erase(index);
+			}
+		}
+
+		template<typename comp>
+		bool tick_price_levels<comp>::erase_order(const price_level::order_handle& handle)
+		{
+			size_t index = find(handle.price);
+			return index != npos ? slots_[index].erase_order(handle.position) : false;
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::erase_level(ats::price_t price)
+		{
+			size_t index = find(price);
+			if (index != npos)
+				erase(index);
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::clean(ats::price_t price)
+		{
+			size_t index = find(price);
+			if (index != npos)
+				slots_[index].clean();
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::execute_all_orders(ats::price_t price, const ats::timestamp_t& time, order_container& orders)
+		{
+			size_t index = find(price);
+			if (index != npos)
+			{
+				slots_[index].execute_all_orders(time, order_status_listener_, orders);
+				erase(index);
+			}
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::execute_orders(ats::price_t price, long quantity, const ats::timestamp_t& time, order_container& orders)
+		{
+			size_t index = find(price);
+			if (index != npos)
+			{
+				slots_[index].execute_orders(quantity, time, order_status_listener_, orders);
+				if (slots_[index].sim_quantity == 0)
+					erase(index);
+			}
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::process_change_msg(const ats::level2_message& msg, order_container& orders)
+		{
+			size_t index = find(msg.price);
+			if (index != npos)
+			{
+				slots_[index].process_change_msg(msg, order_status_listener_, orders);
+
+				if (slots_[index].sim_quantity == 0)
+					erase(index);
+			}
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::process_delete_msg(const ats::level2_message& msg, order_container& orders)
+		{
+			size_t index = find(msg.price);
+			if (index != npos)
+			{
+				if (slots_[index].traded_quantity == msg.quantity)
+					execute_all_orders(msg.price, msg.time, orders);
+				else
+				{
+					slots_[index].clean();
+					slots_[index].traded_quantity = 0;
+				}
+			}
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::process_insert_msg(const ats::level2_message& msg)
+		{
+			size_t index = find(msg.price);
+			if (index != npos)
+			{
+				ats::sim::price_level& level = slots_[index];
+				ats::order_side side = msg.entry_type == ats::entry_type::Bid ?
+					ats::order_side::Buy : ats::order_side::SellShort;
+				if (!level.is_defined())
+				{
+					ats::sim::resting_order order(0, msg.quantity, side);
+					level.insert_order(order);
+				}
+				else
+				{
+					long delta = level.quantity - level.sim_quantity;
+					if (msg.quantity > delta)
+					{
+						ats::sim::resting_order order(0, msg.quantity - delta, side);
+						level.add_order(order);
+					}
+					else if (msg.quantity < delta)
+						level.clean(delta - msg.quantity);
+				}
+			}
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::save(std::ostream& out) const
+		{
+			ats::book_snapshot::write(out, static_cast<uint64_t>(count_));
+			for (size_t n = 0, index = best_; n < count_; index = ascending ? index + 1 : index - 1)
+			{
+				if (used_[index] != 0)
+				{
+					slots_[index].save(out);
+					++n;
+				}
+			}
+		}
+
+		template<typename comp>
+		void tick_price_levels<comp>::load(std::istream& in, const std::string& symbol, order_container& orders)
+		{
+			clear();
+			for (uint64_t n = ats::book_snapshot::read<uint64_t>(in); n > 0; --n)
+			{
+				price_level level(0, pool_.get());
+				level.load(in, symbol);
+				price_level& slot = slots_[find_or_add(level.price())];
+				slot = std::move(level);
+				for (auto order = slot.begin(); order != slot.end(); ++order)
+				{
+					if (order->is_own())
+						orders[order->id()] = price_level::order_handle{ order, slot.price() };
+				}
+			}
+		}
+	}
+}
+
+#endif
\ No newline at end of file
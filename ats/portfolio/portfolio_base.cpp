@@ -4,18 +4,23 @@ namespace ats
 {
 	void portfolio_base::send_order(const order& order)
 	{
+		// Orders that have no time yet are stamped from the clock. Before the first message of a backtest
+		// the clock has no time either, and engines reject such orders (see level2_execution_engine)
+		ats::timestamp_t time = order.transact_time.is_not_a_date_time() ? clock_.now() : order.transact_time;
 		auto engine_it = execution_engines_.find(order.exchange);
 		ats::execution_engine* engine;
 
 		if (engine_it != execution_engines_.cend())
 		{
-			const ats::symbol_key* symbol = get_symbol_key(order.symbol());
+			const ats::symbol_key* symbol = get_symbol_key(order.symbol_id());
 			const std::string& venue_name = engine_it->second->name();
 			//if (symbol != nullptr && order_books_[symbol->index].get(venue_name) != nullptr)
 			if (symbol != nullptr && securities_[symbol->index]->order_book().get(venue_name) != nullptr)
 			{
 				//orders_ += order;
-				orders_.insert(std::make_pair(order.id(), std::make_shared<ats::order>(order)));
+				auto stored = std::make_shared<ats::order>(order);
+				stored->transact_time = time;
+				orders_.insert(std::make_pair(order.id(), stored));
 				engine = engine_it->second;
 				//					venue_it->second->send_order(order);
 			}
@@ -36,11 +41,11 @@ namespace ats
 
 		std::type_index order_type(typeid(order));
 		if (order_type == typeid(ats::market_order))
-			engine->send_order(static_cast<const ats::market_order&>(order));
+			engine->send_order(stamp(static_cast<const ats::market_order&>(order), time));
 		else if (order_type == typeid(ats::limit_order))
-			engine->send_order(static_cast<const ats::limit_order&>(order));
+			engine->send_order(stamp(static_cast<const ats::limit_order&>(order), time));
 		else if (order_type == typeid(ats::stop_order))
-			engine->send_order(static_cast<const ats::stop_order&>(order));
+			engine->send_order(stamp(static_cast<const ats::stop_order&>(order), time));
 	}
 
 	
@@ -53,7 +58,7 @@ namespace ats
 		if (it == orders_.end()) return;
 		auto& ord_ptr = it->second;
 
-		const ats::symbol_key* symbol = get_symbol_key(ord_ptr->symbol());
+		const ats::symbol_key* symbol = get_symbol_key(ord_ptr->symbol_id());
 		if (symbol == nullptr)
 		{
 			std::cout << "ERROR: (Security, Exchange)=(" << ord_ptr->symbol() << "," << ord_ptr->exchange
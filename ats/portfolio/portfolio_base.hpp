@@ -6,9 +6,12 @@
 #include <vector>
 #include <utility>
 #include <memory>
+#include <algorithm>
+#include <ats/date_time/clock.hpp>
 #include <ats/order/order.hpp>
 #include <ats/container/security_container.hpp>
 #include <ats/container/order_container.hpp>
+#include <ats/container/order_index.hpp>
 #include <ats/security/security_base.hpp>
 #include <ats/position/position.hpp>
 
@@ -31,7 +34,10 @@ namespace ats
 		using security_base_ptr = std::shared_ptr<ats::security_base>;
 		using order_ptr = std::shared_ptr<ats::order>;
 	public:
-		portfolio_base() : log_("LOG.txt")
+		portfolio_base() : portfolio_base("LOG.txt") { }
+
+		// Portfolios replayed side by side (e.g., days of a parallel run) are to log into different files
+		explicit portfolio_base(const std::string& log_filename) : log_(log_filename)
 		{
 			// register "global" event handlers (i.e., not having info about the symbol and exchange)
 			this->add_event_handler(&portfolio_base::process_order_status_message, this);
@@ -47,7 +53,18 @@ namespace ats
 		virtual void on_exit() { }
 
 		// Time of the latest message
-		const ats::timestamp_t& current_time() const { return time_; }
+		const ats::timestamp_t& current_time() const { return clock_.time(); }
+
+		// Orders are stamped from the clock: with the time of the latest message, or with the system
+		// time in RealTime mode
+		const ats::date_time::clock& get_clock() const { return clock_; }
+
+		ats::execution_mode get_execution_mode() const { return mode_; }
+		void set_execution_mode(ats::execution_mode mode)
+		{
+			mode_ = mode;
+			clock_.set_real_time(mode == ats::execution_mode::RealTime);
+		}
 
 		void set_bar_parameters(const boost::posix_time::time_duration& bar_periodicity,
 				size_t bars_to_store)
@@ -64,7 +81,7 @@ namespace ats
 		// Update time whenever a new message is received
 		void on_time_update(const ats::timestamp_t& time)
 		{
-			time_ = time;
+			clock_.update(time);
 
 /*			for (auto& sec: securities_)
 				sec->process_time_update(time);*/
@@ -77,7 +94,7 @@ namespace ats
 		{
 			on_time_update(msg.time);
 
-			const ats::symbol_key* symbol = get_symbol_key(msg.symbol);
+			const ats::symbol_key* symbol = get_symbol_key(msg.symbol_id);
 			if (symbol != nullptr)
 				securities_[symbol->index]->process_message(msg);
 		}
@@ -118,13 +135,15 @@ namespace ats
 					cancel_order(order->id());
 				}
 			}*/
-			for (auto it = orders_.begin(); it != orders_.end();)
+			// Cancelling erases orders from orders_, so the ids are collected first
+			std::vector<ats::orderid_t> ids;
+			for (const auto& order : orders_)
 			{
-				if (it->second->is_pending())
-					cancel_order((it++)->second->id());
-				else
-					++it;
+				if (order.second->is_pending())
+					ids.push_back(order.first);
 			}
+			for (const auto& id : ids)
+				cancel_order(id);
 		}
 
 	public:
@@ -142,36 +161,37 @@ namespace ats
 
 			if (engine->subscription() == ats::subscription::Level2)
 			{
-				ats::level2_execution_engine* l2_engine = static_cast<ats::level2_execution_engine*>(engine);
-				l2_engine->add_order_book_changed_listener([=](const ats::level2_message_packet& msg) { process_message(msg); });
+				// Not every level2 engine simulates orders itself (e.g., ats::level2_sweep)
+				auto listener = [=](const ats::level2_message_packet& msg) { process_message(msg); };
+				if (auto* l2_engine = dynamic_cast<ats::level2_execution_engine*>(engine))
+					l2_engine->add_order_book_changed_listener(listener);
+				else if (auto* tick_engine = dynamic_cast<ats::tick_level2_execution_engine*>(engine))
+					tick_engine->add_order_book_changed_listener(listener);
 			}
 			else if (engine->subscription() == ats::subscription::TimeAndSales)
 			{
 			}
 
 			execution_engines_.insert(std::make_pair(engine->name(), engine));
+
+			ats::exchange_id_t exchange = ats::exchange_registry().intern(engine->name());
+			if (exchange >= engines_by_exchange_.size())
+				engines_by_exchange_.resize(exchange + 1, nullptr);
+			engines_by_exchange_[exchange] = engine;
 		}
 
 		std::ofstream& LOG() { return log_;	}
 
 		void add_security(ats::security_base* sec)
 		{
-			const ats::symbol_key& symbol = sec->symbol();
-			symbols_.push_back(symbol);
-			symbol_keys_.insert(std::make_pair(symbol.name, symbol));
-			positions_.push_back(ats::position(symbol));
-
+			add_symbol(sec->symbol());
 			securities_.push_back(security_base_ptr(dynamic_cast<decltype(sec)>(sec)));
 		}
 
 		void add_security(const security_base_ptr& sec)
 		{
 			securities_.push_back(sec);
-
-			const ats::symbol_key& symbol = sec->symbol();
-			symbols_.push_back(symbol);
-			symbol_keys_.insert(std::make_pair(symbol.name, symbol));
-			positions_.push_back(ats::position(symbol));
+			add_symbol(sec->symbol());
 		}
 
 		void create_order_book(const std::string& symbol, const std::string& exchange, size_t book_depth = 10U)
@@ -188,6 +208,11 @@ namespace ats
 			return find != execution_engines_.end() ? find->second : nullptr;
 		}
 
+		ats::execution_engine* get_execution_engine(ats::exchange_id_t exchange) const
+		{
+			return exchange < engines_by_exchange_.size() ? engines_by_exchange_[exchange] : nullptr;
+		}
+
 		const std::vector<ats::symbol_key>& get_symbols() const { return symbols_; }
 
 		security_base_ptr& get_security(const ats::symbol_key& symbol)
@@ -221,6 +246,29 @@ namespace ats
 			return it != symbol_keys_.cend() ? &it->second : nullptr;
 		}
 
+		const ats::symbol_key* get_symbol_key(ats::symbol_id_t symbol) const
+		{
+			return symbol < symbol_indexes_.size() && symbol_indexes_[symbol] != npos ? &symbols_[symbol_indexes_[symbol]] : nullptr;
+		}
+
+		// Copies the books of an execution engine into the order books of the securities, e.g., after the
+		// engine has loaded a snapshot (see level2_execution_engine::load_snapshot)
+		template<typename book_type>
+		void load_order_books(const ats::basic_level2_execution_engine<book_type>& engine)
+		{
+			for (auto& sec : securities_)
+			{
+				ats::exchange_order_book* book = sec->order_book_.get(engine.name());
+				const ats::exchange_order_book* engine_book = engine.get_order_book(sec->symbol().to_string());
+				if (book != nullptr && engine_book != nullptr)
+				{
+					*book = *engine_book;
+					if (sec->order_book_.is_consolidated())
+						sec->order_book_.consolidate();
+				}
+			}
+		}
+
 		const ats::order_book& get_order_book(const ats::symbol_key& symbol) const
 		{
 //			return order_books_[symbol.index];
@@ -235,18 +283,48 @@ namespace ats
 
 		const ats::report_engine& get_report() const { return report_; }
 
+		// Counters are kept per portfolio, so that ids do not depend on other portfolios replayed in the process
 		size_t get_next_order_id() const
 		{
-			static size_t id = 1;
-			return id++;
+			return next_order_id_++;
 		}
 
 
 //	private:
 		size_t get_next_symbol_key() const
 		{
-			static size_t index = 0;
-			return index++;
+			return next_symbol_index_++;
+		}
+
+		bool is_flat() const
+		{
+			return std::all_of(positions_.cbegin(), positions_.cend(), [](const ats::position& pos) { return pos.quantity() == 0; });
+		}
+
+		// Takes over the positions of another portfolio trading the same symbols, e.g., positions held
+		// overnight by the portfolio of the previous day
+		void load_positions(const portfolio_base& other)
+		{
+			for (const auto& symbol : other.symbols_)
+			{
+				const ats::symbol_key* key = get_symbol_key(symbol.id);
+				if (key != nullptr)
+					positions_[key->index] = other.positions_[symbol.index];
+			}
+		}
+
+		// Closes open positions at the last trade price of their securities, e.g., at the end of a trading day
+		void close_positions()
+		{
+			for (const auto& symbol : symbols_)
+			{
+				const ats::position& pos = positions_[symbol.index];
+				if (pos.quantity() != 0)
+				{
+					process_execution(symbol, pos.is_long() ? ats::order_side::Sell : ats::order_side::BuyCover,
+						pos.quantity(), securities_[symbol.index]->last_price(), current_time());
+				}
+			}
 		}
 
 		void process_execution(const ats::symbol_key& symbol, ats::order_side side, long quantity,
@@ -269,16 +347,42 @@ namespace ats
 			}
 		}
 
+	private:
+		void add_symbol(const ats::symbol_key& symbol)
+		{
+			if (symbol.id >= symbol_indexes_.size())
+				symbol_indexes_.resize(symbol.id + 1, npos);
+			symbol_indexes_[symbol.id] = symbols_.size();
+
+			symbols_.push_back(symbol);
+			symbol_keys_.insert(std::make_pair(symbol.name, symbol));
+			positions_.push_back(ats::position(symbol));
+		}
+
+		// Copy of an order with the time it is sent at
+		template<typename OrderT>
+		static OrderT stamp(const OrderT& order, const ats::timestamp_t& time)
+		{
+			OrderT stamped(order);
+			stamped.transact_time = time;
+			return stamped;
+		}
+
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
 	private:
 //		ats::security_container securities_;                              // securities to be traded
 		std::vector<ats::symbol_key> symbols_;
 		std::vector<security_base_ptr> securities_;
 		std::unordered_map<std::string, ats::execution_engine*> execution_engines_;
+		std::vector<ats::execution_engine*> engines_by_exchange_;  // by interned exchange, for messages
+		std::vector<size_t> symbol_indexes_;                       // indexes into symbols_ by interned symbol
 
 		// To work with orders
 //		ats::order_container orders_; // orders that have been submitted
-		std::unordered_map<ats::orderid_t, order_ptr> orders_;
-		ats::timestamp_t time_;       // time of the last message
+		ats::order_index<order_ptr> orders_;
+		ats::date_time::clock clock_;  // time of the last message, or system time in RealTime mode
+		ats::execution_mode mode_ = ats::execution_mode::BackTesting;
 
 		std::ofstream log_;
 
@@ -289,6 +393,9 @@ namespace ats
 		boost::posix_time::time_duration bar_periodicity_;
 		size_t bars_to_store_ = 0;
 
+		mutable size_t next_order_id_ = 1;
+		mutable size_t next_symbol_index_ = 0;
+
 	protected:
 		std::unordered_map<std::string, ats::symbol_key> symbol_keys_;
 	};
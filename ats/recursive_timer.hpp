@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <list>
+#include <ats/types.hpp>
 
 namespace ats
 {
@@ -13,15 +14,15 @@ namespace ats
 		typedef std::function<void(const ats::timestamp_t&)> time_listener;
 
 		recursive_timer(const boost::posix_time::time_duration& period = boost::posix_time::seconds(1))
-			: period_(period) { }
+			: period_(ats::date_time::to_duration(period)) { }
 
-		void init(const boost::posix_time::time_duration& period) { period_ = period; }
+		void init(const boost::posix_time::time_duration& period) { period_ = ats::date_time::to_duration(period); }
 
 		void update(const ats::timestamp_t& time)
 		{
-			if (end_time_.is_not_a_date_time() || time.date() != end_time_.date())
+			if (end_time_.is_not_a_date_time() || time.start_of_day() != end_time_.start_of_day())
 			{
-				end_time_ = time.date();
+				end_time_ = time.start_of_day();
 				while (end_time_ + period_ < time)
 					end_time_ += period_;
 
@@ -47,7 +48,7 @@ namespace ats
 		}
 
 	private:
-		boost::posix_time::time_duration period_;
+		ats::timestamp_t::duration period_;
 		ats::timestamp_t end_time_;
 		std::list<time_listener> time_listeners_;
 	};
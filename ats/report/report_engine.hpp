@@ -37,6 +37,16 @@ namespace ats
 			performance_.push_back(item);
 		}
 
+		// Appends the items of another report starting from its item first, e.g., to merge the reports of
+		// days replayed separately
+		void append(const report_engine& other, size_t first = 0)
+		{
+			if (first < other.performance_.size())
+				performance_.insert(performance_.end(), other.performance_.cbegin() + first, other.performance_.cend());
+		}
+
+		size_t size() const { return performance_.size(); }
+
 		iterator begin() { return performance_.begin(); }
 		const_iterator cbegin() const { return performance_.cbegin(); }
 		iterator end() { return performance_.end(); }
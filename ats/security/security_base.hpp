@@ -7,6 +7,8 @@
 #include <functional>
 #include <memory>
 #include <list>
+#include <vector>
+#include <algorithm>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/posix_time/posix_time_io.hpp>
 
@@ -38,7 +40,7 @@ namespace ats
 		security_base(const ats::symbol_key& symbol, portfolio_base* portfolio,
 				const boost::posix_time::time_duration bar_periodicity,	size_t bars_to_store)
 			: symbol_(symbol), order_book_(symbol), portfolio_(portfolio),
-			  bars_(bars_to_store), bar_periodicity_(bar_periodicity)
+			  bars_(bars_to_store), bar_periodicity_(ats::date_time::to_duration(bar_periodicity))
 		{
 			on_init();
 		}
@@ -77,6 +79,12 @@ namespace ats
 			// Update the time of the last received message
 			last_update_time_ = msg.time;
 
+			if (is_subscribed())
+			{
+				process_subscribed_message(msg);
+				return;
+			}
+
 			// Transform the message into a "message with deltas"
 			ats::level2_message_packet msg_delta = msg;
 			for (auto& m : msg_delta.messages)
@@ -98,8 +106,18 @@ namespace ats
 		void create_order_book(const std::string& exchange, size_t book_depth)
 		{
 			order_book_.add_order_book(exchange, book_depth);
+			order_book_.get(exchange)->track_depth(tracked_depth());
 		}
 
+		// Subscriptions. Without any, every packet is passed to on_order_book_changed. Once subscribed,
+		// packets are passed to on_bbo_changed, on_depth_changed and on_trade only if they change what the
+		// security subscribed to, and on_order_book_changed is no longer called
+		void subscribe_bbo() { is_bbo_subscribed_ = true; track_books(); }
+		void subscribe_depth(size_t levels) { subscribed_depth_ = std::max(subscribed_depth_, levels); track_books(); }
+		void subscribe_trades() { is_trade_subscribed_ = true; }
+
+		bool is_subscribed() const { return is_bbo_subscribed_ || subscribed_depth_ != 0 || is_trade_subscribed_; }
+
 	// Events
 	public:
 		virtual void on_init() { }
@@ -110,6 +128,10 @@ namespace ats
 		virtual void on_order_book_changed(const ats::level2_message_packet& msg) { }
 		virtual void on_trade(const ats::trade_message& msg) { }
 
+		// The top of a book changed, or its top level levels, level being the best level that did
+		virtual void on_bbo_changed(const ats::exchange_order_book& book) { }
+		virtual void on_depth_changed(const ats::exchange_order_book& book, size_t level) { }
+
 		virtual void on_bar_open(const ats::bar& bar) { }
 		virtual void on_bar_close(const ats::bar& bar) { }
 
@@ -122,7 +144,7 @@ namespace ats
 
 		void set_bar_parameters(const boost::posix_time::time_duration& bar_periodicity, size_t bars_to_store)
 		{
-			bar_periodicity_ = bar_periodicity;
+			bar_periodicity_ = ats::date_time::to_duration(bar_periodicity);
 			bars_.set_capacity(bars_to_store);
 		}
 
@@ -140,13 +162,30 @@ namespace ats
 
 		// To construct bars
 		bar_container bars_;
-		boost::posix_time::time_duration bar_periodicity_;
+		ats::timestamp_t::duration bar_periodicity_ = ats::timestamp_t::duration::zero();
 
 		ats::timestamp_t last_update_time_;
 		ats::price_t last_price_ = 0;
 
 		std::list<time_listener> time_listeners_;
 
+		// Subscriptions (see subscribe_bbo)
+		bool is_bbo_subscribed_ = false;
+		size_t subscribed_depth_ = 0;
+		bool is_trade_subscribed_ = false;
+		std::vector<ats::trade_message> trades_;  // trades of the packet being processed
+
+	private:
+		size_t tracked_depth() const { return std::max<size_t>(subscribed_depth_, is_bbo_subscribed_ ? 1 : 0); }
+
+		void track_books()
+		{
+			for (auto& book : order_book_)
+				book.second.track_depth(tracked_depth());
+		}
+
+		void process_subscribed_message(const ats::level2_message_packet& msg);
+
 	protected:
 		ats::portfolio_base* portfolio_;
 	};
@@ -156,6 +195,53 @@ namespace ats
 
 
 
+	inline void security_base::process_subscribed_message(const ats::level2_message_packet& msg)
+	{
+		// Messages are updated one at a time, the packet is not copied
+		trades_.clear();
+		for (const auto& m : msg.messages)
+		{
+			ats::level2_message delta = m;
+			order_book_.update2(delta);
+			if (delta.entry_type == ats::entry_type::Trade)
+			{
+				update_bars(delta.time, delta.price, delta.quantity);
+				last_price_ = delta.price;
+
+				if (is_trade_subscribed_)
+				{
+					ats::trade_message trade;
+					trade.time = delta.time;
+					trade.symbol_id = delta.symbol_id;
+					trade.exchange_id = delta.exchange_id;
+					trade.price = delta.price;
+					trade.quantity = delta.quantity;
+					trade.seq_number = delta.seq_number;
+					trade.state = delta.state;
+					trade.aggressor_side = delta.aggressor_side > 0 ? ats::aggressor_side::Buy :
+						(delta.aggressor_side < 0 ? ats::aggressor_side::Sell : ats::aggressor_side::Undefined);
+					trades_.push_back(trade);
+				}
+			}
+		}
+
+		process_time_update(msg.time);
+
+		// Respond once the packet is applied, so that the books are consistent
+		for (auto& it : order_book_)
+		{
+			ats::exchange_order_book& book = it.second;
+			if (is_bbo_subscribed_ && book.bbo_changed())
+				on_bbo_changed(book);
+			if (book.depth_changed(subscribed_depth_))
+				on_depth_changed(book, book.changed_level());
+			book.clear_changes();
+		}
+
+		for (const auto& trade : trades_)
+			on_trade(trade);
+	}
+
 	inline void security_base::update_bars(const ats::timestamp_t& time, ats::price_t price, long quantity)
 	{
 		if (bars_.capacity() == 0) return;
@@ -164,7 +250,7 @@ namespace ats
 
 		if (bars_.empty())
 		{
-			ats::date_time::date_time time_close = time.date();
+			ats::timestamp_t time_close = time.start_of_day();
 			while (time_close <= time)
 				time_close += bar_periodicity_;
 
@@ -198,7 +284,7 @@ namespace ats
 				new_bar.time_open = last_bar.time_open + bar_periodicity_;
 
 				// Insert empty bars if there were no trades for a long time
-				ats::date_time::date_time time_close(new_bar.time_open + bar_periodicity_);
+				ats::timestamp_t time_close(new_bar.time_open + bar_periodicity_);
 				while (time_close < time)
 				{
 					ats::bar empty_bar;
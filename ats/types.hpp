@@ -5,22 +5,26 @@
 #include <cstdint>
 #include <string>
 #include <ostream>
-#include <ats/date_time/date_time.hpp>
+#include <ats/date_time/timestamp.hpp>
+#include <ats/container/name_registry.hpp>
 
 namespace ats
 {
 	using price_t = int;
-	using timestamp_t = ats::date_time::date_time;//uint64_t;
+	using timestamp_t = ats::date_time::timestamp;
 	using orderid_t = uint64_t;
+	using symbol_id_t = ats::name_registry::id_type;    // see ats::symbol_registry
+	using exchange_id_t = ats::name_registry::id_type;  // see ats::exchange_registry
 //	using quantity_t = uint64_t;
 
 	struct symbol_key
 	{
 		std::string name;
 		size_t index;
+		ats::symbol_id_t id;  // interned name
 
 		symbol_key(const std::string& symbol, size_t index)
-			: name(symbol), index(index) { }
+			: name(symbol), index(index), id(ats::symbol_registry().intern(symbol)) { }
 
 		const std::string& to_string() const { return name; }
 
@@ -9,66 +9,171 @@
 #include <map>
 #include <fstream>
 #include <algorithm>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <charconv>
+#include <string_view>
 #include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
 #include <ats/custom_message_readers/level2_message_reader.hpp>
+#include <ats/custom_message_readers/level2_mmap_message_reader.hpp>
+#include <ats/custom_message_readers/level2_binary_message_reader.hpp>
+#include <ats/data_feed/historical/async_message_reader.hpp>
+#include <ats/concurrency/thread_pool.hpp>
+#include <ats/io/writer/level2_csv_to_binary.hpp>
 #include <ats/order_book/exchange_order_book.hpp>
 
-void transform(const std::string& dir, const std::string& filename)
+// Day file of a vendor file: "Results/<head>/<head>.txt" where head holds the exchange, symbol and date
+boost::filesystem::path transform_target(const std::string& filename)
 {
 	std::string head = filename.substr(0, 3);
 	std::transform(head.begin(), head.end(), head.begin(), toupper);
 	head += "_" + filename.substr(4, 13);
+	if (head.size() < 17)
+		throw std::invalid_argument("transform: Invalid vendor file name '" + filename + "'");
 
-	std::string folder = "Results/" + head.substr(0, 6);
-	boost::filesystem::path directory(folder);
-	if (!boost::filesystem::exists(directory))
-		boost::filesystem::create_directory(directory);
+	return boost::filesystem::path("Results/" + head.substr(0, 6)) / (head + ".txt");
+}
 
-	std::ifstream file(dir + filename);
-	std::ofstream out(folder + "/" + head + ".txt");
+// Converts a vendor file into a level2 day file. Vendor lines hold the time in microseconds since
+// midnight, followed by the fields of the day file; lines with fewer fields become packet separators.
+// The day file is written under a temporary name and renamed when complete, so that a day file that
+// exists is never partial
+void transform_file(const std::string& source, const boost::filesystem::path& target)
+{
+	std::string stem = target.stem().string();
+	ats::timestamp_t date(stem.substr(9, 8), "%Y%m%d");
 
-	ats::timestamp_t date(head.substr(9, 8), "%Y%m%d");
+	boost::iostreams::mapped_file_source file;
+	boost::system::error_code ec;
+	if (boost::filesystem::file_size(source, ec) > 0 && !ec)
+		file.open(source);
+	const char* pos = file.is_open() ? file.data() : nullptr;
+	const char* end = file.is_open() ? pos + file.size() : nullptr;
 
-	std::string line;
-	std::array<std::string, 7> fields;
-	while (std::getline(file, line))
+	boost::filesystem::path tmp(target.string() + ".tmp");
+	std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+
+	std::string buffer;
+	std::array<std::string_view, 7> fields;
+	ats::date_time::timestamp_formatter formatter;
+	char time_str[32];
+	while (pos < end)
 	{
+		const char* eol = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+		if (eol == nullptr)
+			eol = end;
+		std::string_view line(pos, eol - pos);
+		pos = eol < end ? eol + 1 : end;
+
 		if (ats::tokenize(line, fields, ',') < fields.size())
 		{
-			out << '\n';
+			buffer += '\n';
 			continue;
 		}
 
-		long microseconds = std::stol(fields[0]);
-		ats::timestamp_t time(date + boost::posix_time::microseconds(microseconds));
+		long microseconds;
+		if (std::from_chars(fields[0].data(), fields[0].data() + fields[0].size(), microseconds).ec != std::errc())
+			throw std::invalid_argument("transform: Invalid time '" + std::string(fields[0]) + "' in '" + source + "'");
+		ats::timestamp_t time(date.nanoseconds() + microseconds * 1000);
 
-		char update_action;
-		char entry_type;
+		char update_action = 'N';
+		char entry_type = 'T';
 		if (fields[1] == "C") update_action = 'C';
 		else if (fields[1] == "D") update_action = 'D';
-		else if (fields[1] == "A") update_action = 'N';
-		else if (fields[1] == "T")
-		{
-			update_action = 'N';
-			entry_type = 'T';
-		}
 
 		if (fields[2] == "B") entry_type = 'B';
 		else if (fields[2] == "A") entry_type = 'A';
 
-		out << time.to_string("%Y%m%d %H%M%S.%f") << ',' << update_action << ',' << entry_type;
+		buffer.append(time_str, formatter.format(time, time_str));
+		buffer += ',';
+		buffer += update_action;
+		buffer += ',';
+		buffer += entry_type;
 		for (size_t i = 3; i < fields.size(); ++i)
-			out << ',' << fields[i];
-		out << '\n';
+		{
+			buffer += ',';
+			buffer.append(fields[i].data(), fields[i].size());
+		}
+		buffer += '\n';
+
+		if (buffer.size() >= (1U << 20))
+		{
+			out.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
 	}
 
+	out.write(buffer.data(), buffer.size());
 	out.close();
-	file.close();
+	if (!out)
+		throw std::runtime_error("transform: Cannot write '" + tmp.string() + "'");
+	boost::filesystem::rename(tmp, target);
 }
 
+void transform(const std::string& dir, const std::string& filename)
+{
+	boost::filesystem::path target = transform_target(filename);
+	boost::filesystem::create_directories(target.parent_path());
+	transform_file(dir + filename, target);
+}
+
+// Converts the vendor files of a directory (see transform()) concurrently, on a thread pool of the given
+// size (one thread per hardware thread if zero). Files whose day file exists are skipped, so that an
+// interrupted run resumes where it stopped. Files that cannot be converted are reported and left out;
+// returns the number of converted files
+size_t transform_directory(const std::string& dir, size_t threads = 0)
+{
+	std::vector<std::pair<std::string, boost::filesystem::path>> files;
+	boost::filesystem::directory_iterator it(dir), end;
+	for (; it != end; ++it)
+	{
+		if (!boost::filesystem::is_regular_file(it->status()))
+			continue;
+
+		std::string filename = it->path().filename().string();
+		try
+		{
+			boost::filesystem::path target = transform_target(filename);
+			if (boost::filesystem::exists(target))
+				continue;
+			boost::filesystem::create_directories(target.parent_path());
+			files.emplace_back(it->path().string(), target);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "ERROR: Cannot convert '" + filename + "': " + e.what() + '\n';
+		}
+	}
+
+	ats::thread_pool pool(threads);
+	std::vector<std::future<void>> results;
+	results.reserve(files.size());
+	for (const auto& file : files)
+		results.push_back(pool.submit([&file]() { transform_file(file.first, file.second); }));
+
+	size_t count = 0;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		try
+		{
+			results[i].get();
+			++count;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "ERROR: Cannot convert '" + files[i].first + "': " + e.what() + '\n';
+		}
+	}
+	return count;
+}
 
 void to_trades(const std::string& dir, const std::string& filename)
 {
@@ -110,6 +215,15 @@ void to_trades(const std::string& dir, const std::string& filename)
 	out.close();
 }
 
+// Converts a level2 day file into the binary format. The result is stored next to the source file
+// with the extension .l2b, where run() picks it up instead of the CSV file
+void to_binary(const std::string& dir, const std::string& filename)
+{
+	boost::filesystem::path binary(dir + filename);
+	binary.replace_extension(".l2b");
+	ats::level2_csv_to_binary(dir + filename, binary.string());
+}
+
 // Returns (Exchange, Symbol)
 std::pair<std::string, std::string> get_full_symbol(const std::string& filename)
 {
@@ -138,11 +252,14 @@ ats::timestamp_t get_date(const std::string& filename)
 	return ats::timestamp_t(date, "%Y%m%d");
 }
 
-void run(const std::vector<std::string>& symbols, const std::string& datasource,
-		const std::string& date1, const std::string& date2,	portfolio& port)
+using day_files_type = std::map<ats::timestamp_t, std::vector<std::pair<std::string, std::string>>>;
+using sessions_type = std::vector<std::pair<boost::posix_time::time_duration, boost::posix_time::time_duration>>;
+
+// Day files of the symbols ("Exchange_Symbol") between two dates: (Exchange, Symbol) pairs by date
+day_files_type find_day_files(const std::vector<std::string>& symbols, const std::string& datasource,
+		const std::string& date1, const std::string& date2)
 {
-	using pair = std::pair<std::string, std::string>;
-	std::multimap<ats::timestamp_t, pair> files;
+	day_files_type files;
 
 	ats::timestamp_t time1(date1, "%Y%m%d");
 	ats::timestamp_t time2(date2, "%Y%m%d");
@@ -166,31 +283,173 @@ void run(const std::vector<std::string>& symbols, const std::string& datasource,
 			filename = it->path().filename().c_str();
 			ats::timestamp_t time = get_date(filename);
 			if (time >= time1 && time <= time2)
-				files.insert(std::make_pair(time, std::make_pair(exchange, symbol)));
+			{
+				// A day may be stored both as a CSV file and as its binary counterpart
+				auto& day = files[time];
+				auto key = std::make_pair(exchange, symbol);
+				if (std::find(day.cbegin(), day.cend(), key) == day.cend())
+					day.push_back(key);
+			}
 		}
 	}
+	return files;
+}
+
+// Replays the files of a day into a portfolio (see run() for sessions and read_ahead)
+void replay_day(const ats::timestamp_t& date, const std::vector<std::pair<std::string, std::string>>& files,
+		const std::string& datasource, portfolio& port, const sessions_type& sessions, bool read_ahead)
+{
+	using reader_ptr_type = std::shared_ptr<ats::message_reader>;
+	using level2_reader_type = ats::exchange_message_reader_base<ats::level2_message_packet>;
+	auto make_reader = [read_ahead](level2_reader_type* reader) -> reader_ptr_type
+	{
+		if (read_ahead)
+			return std::make_shared<ats::async_message_reader<ats::level2_message_packet>>(std::unique_ptr<level2_reader_type>(reader));
+		return reader_ptr_type(reader);
+	};
 
-	using reader_type = ats::l2_message_reader;
-	using reader_ptr_type = std::shared_ptr<reader_type>;
-	for (auto it = files.cbegin(); it != files.cend(); it = files.upper_bound(it->first))
+	ats::historical_data_feed feed(&port);
+	for (const auto& file : files)
 	{
 		std::stringstream ss;
-		std::string symbol = it->second.second;
-		std::string exchange = it->second.first;
+		std::string symbol = file.second;
+		std::string exchange = file.first;
 		std::string folder = exchange + '_' + symbol;
-		ss << datasource << folder << '/' << folder << '_' << it->first.to_string("%Y%m%d") << ".txt";
-		std::cout << ss.str() << '\n';
+		ss << datasource << folder << '/' << folder << '_' << date.to_string("%Y%m%d") << ".txt";
+
+		// Prefer the binary version of the day file when it exists. File names are printed with a single
+		// write, so that lines of days replayed in parallel do not interleave
+		boost::filesystem::path binary(ss.str());
+		binary.replace_extension(".l2b");
+		if (boost::filesystem::exists(binary))
+		{
+			std::cout << binary.string() + '\n';
+			feed.add_message_reader(make_reader(new ats::l2_binary_message_reader(binary.string(), symbol, exchange)));
+		}
+		else
+		{
+			std::cout << ss.str() + '\n';
+			feed.add_message_reader(make_reader(new ats::l2_mmap_message_reader(ss.str(), symbol, exchange)));
+		}
+	}
+
+	std::vector<ats::time_window> windows;
+	for (const auto& session : sessions)
+	{
+		windows.push_back(ats::time_window{ date + ats::date_time::to_duration(session.first),
+			date + ats::date_time::to_duration(session.second) });
+	}
+	feed.set_time_windows(std::move(windows));
+
+	// Replay
+	feed.run();
+}
+
+// Sessions are times of day [begin, end) to replay, every day (e.g., regular trading hours); the whole day is
+// replayed if there is none. With read_ahead, every day file is decoded on its own background thread
+// (see ats::async_message_reader)
+void run(const std::vector<std::string>& symbols, const std::string& datasource,
+		const std::string& date1, const std::string& date2,	portfolio& port,
+		const sessions_type& sessions = {}, bool read_ahead = false)
+{
+	for (const auto& day : find_day_files(symbols, datasource, date1, date2))
+		replay_day(day.first, day.second, datasource, port, sessions, read_ahead);
+}
 
-		ats::historical_data_feed feed(&port);
-		for (auto ii = it; ii != files.upper_bound(it->first); ++ii)
+// How run_parallel() treats positions still open at the end of a day
+enum class carry_policy
+{
+	FlatAtClose,  // every day is closed at the last trade prices, so that days are independent
+	Sequential    // positions are carried into the next day
+};
+
+// Log file of the portfolio of a day replayed by run_parallel(), e.g., "LOG_20141103.txt"
+std::string day_log_filename(const ats::timestamp_t& date)
+{
+	return "LOG_" + date.to_string("%Y%m%d") + ".txt";
+}
+
+using portfolio_factory_type = std::function<std::shared_ptr<portfolio>(const ats::timestamp_t& date, const std::string& log_filename)>;
+
+// Replays the days between two dates on a thread pool (one thread per hardware thread if threads is zero).
+// Every day is replayed into its own portfolio made by the factory from the date and the log file of the
+// day (see day_log_filename), so that days replayed at the same time do not write to the same log. The
+// factory is to connect the execution engines of the portfolio (and keep them alive as long as the
+// portfolio). The reports of the days are merged in date order. With read_ahead, every day file is also
+// decoded on a thread of its own, so that fewer days are replayed at the same time.
+//
+// With carry_policy::Sequential, the portfolio of a day takes over the positions the previous day ended
+// with (see portfolio_base::load_positions); the rest of the state of a portfolio is not carried over days.
+// A day is replayed from flat while the previous day is still running, unless the latest day to finish
+// ended with open positions, in which case it waits for the previous day instead. A day replayed from flat
+// is replayed again, with the carried positions, only if the previous day turns out to end with open positions
+ats::report_engine run_parallel(const std::vector<std::string>& symbols, const std::string& datasource,
+		const std::string& date1, const std::string& date2, const portfolio_factory_type& factory,
+		carry_policy policy = carry_policy::FlatAtClose, size_t threads = 0,
+		const sessions_type& sessions = {}, bool read_ahead = false)
+{
+	using result_type = std::shared_future<std::shared_ptr<portfolio>>;
+
+	day_files_type files = find_day_files(symbols, datasource, date1, date2);
+
+	if (threads == 0)
+		threads = std::max(1U, std::thread::hardware_concurrency());
+	if (read_ahead)
+	{
+		size_t files_per_day = 0;
+		for (const auto& day : files)
+			files_per_day = std::max(files_per_day, day.second.size());
+		threads = std::max<size_t>(1U, threads / (1 + files_per_day));
+	}
+
+	auto replay = [&](const day_files_type::value_type& day, const portfolio* carried)
+	{
+		std::shared_ptr<portfolio> port = factory(day.first, day_log_filename(day.first));
+		if (carried != nullptr)
+			port->load_positions(*carried);
+		replay_day(day.first, day.second, datasource, *port, sessions, read_ahead);
+		if (policy == carry_policy::FlatAtClose)
+			port->close_positions();
+		return port;
+	};
+
+	std::vector<result_type> days;
+	std::atomic<bool> is_holding{ false };  // the latest day to finish ended with open positions
+	{
+		// Tasks start in date order, so that a day only waits for a day already running
+		ats::thread_pool pool(threads);
+		for (const auto& day : files)
 		{
-			reader_ptr_type reader(new reader_type(ss.str(), symbol, exchange));
-			feed.add_message_reader(reader);
+			result_type previous = days.empty() ? result_type() : days.back();
+			days.push_back(pool.submit([&, day, previous]()
+			{
+				if (policy == carry_policy::FlatAtClose || !previous.valid())
+					return replay(day, nullptr);
+
+				std::shared_ptr<portfolio> port;
+				if (previous.wait_for(std::chrono::seconds(0)) != std::future_status::ready && !is_holding.load())
+					port = replay(day, nullptr);
+
+				// Rethrows the exception of a failed previous day
+				const std::shared_ptr<portfolio>& carried = previous.get();
+				if (!carried->is_flat())
+					port = replay(day, carried.get());
+				else if (port == nullptr)
+					port = replay(day, nullptr);
+
+				is_holding.store(!port->is_flat());
+				return port;
+			}).share());
 		}
+	}
 
-		// Replay
-		feed.run();
+	ats::report_engine report;
+	for (auto& result : days)
+	{
+		// Rethrows the exception of a failed day
+		report.append(result.get()->get_report());
 	}
+	return report;
 }
 
 #endif